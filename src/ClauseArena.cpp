@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <cassert>
+
+#include "ClauseArena.h"
+
+#define HEADER_WORDS (sizeof(Clause) / sizeof(uint32_t))
+
+ClauseRef ClauseArena::allocate(const std::vector<Literal> &literals, bool learned) {
+    return allocate(literals.data(), literals.data() + literals.size(), learned);
+}
+
+ClauseRef ClauseArena::allocate(const Literal *begin, const Literal *end, bool learned) {
+    auto size = static_cast<size_t>(end - begin);
+    assert(memory.size() + HEADER_WORDS + size < CLAUSE_NONE);
+
+    auto ref = static_cast<ClauseRef>(memory.size());
+    memory.resize(memory.size() + HEADER_WORDS + size);
+
+    Clause &clause = (*this)[ref];
+    clause.size = static_cast<uint32_t>(size);
+    clause.learned = learned;
+    clause.deleted = false;
+    clause.used = false;
+    clause.relocated = false;
+    clause.vivified = false;
+    clause.lbd = 0;
+    clause.activity = 0;
+    std::copy(begin, end, clause.begin());
+
+    return ref;
+}
+
+void ClauseArena::free(ClauseRef ref) {
+    Clause &clause = (*this)[ref];
+    if (clause.deleted) return;
+    clause.deleted = true;
+    wasted_words += HEADER_WORDS + clause.size;
+}
+
+void ClauseArena::relocate(ClauseRef &ref, ClauseArena &to) {
+    Clause &clause = (*this)[ref];
+    if (clause.relocated) {
+        ref = clause[0];
+        return;
+    }
+
+    ClauseRef new_ref = to.allocate(clause.begin(), clause.end(), clause.learned);
+    Clause &new_clause = to[new_ref];
+    new_clause.used = clause.used;
+    new_clause.vivified = clause.vivified;
+    new_clause.lbd = clause.lbd;
+    new_clause.activity = clause.activity;
+
+    clause.relocated = true;
+    if (clause.size > 0) {
+        clause[0] = new_ref;
+    }
+    ref = new_ref;
+}
+
+void ClauseArena::reserve(size_t words) {
+    memory.reserve(words);
+}
+
+size_t ClauseArena::size() const {
+    return memory.size();
+}
+
+size_t ClauseArena::wasted() const {
+    return wasted_words;
+}
+
+void ClauseArena::clear() {
+    memory.clear();
+    wasted_words = 0;
+}
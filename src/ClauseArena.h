@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Literal.h"
+
+// Clauses are addressed by their word offset inside the arena.
+typedef uint32_t ClauseRef;
+
+const ClauseRef CLAUSE_NONE = UINT32_MAX;
+
+// Clause header stored in-line in the arena, immediately followed by `size` literals.
+struct Clause {
+    uint32_t size;
+    uint32_t learned: 1;
+    uint32_t deleted: 1;
+    // Set when a learned clause takes part in a conflict, cleared by every database reduction.
+    uint32_t used: 1;
+    // Set once the clause has been moved by garbage collection; its first literal holds the new reference.
+    uint32_t relocated: 1;
+    // Set once inprocessing has tried to shorten the learned clause.
+    uint32_t vivified: 1;
+    // Lowest number of distinct decision levels seen in the clause since it was learned.
+    uint32_t lbd: 27;
+    float activity;
+
+    Literal *begin() {
+        return reinterpret_cast<Literal *>(this + 1);
+    }
+
+    Literal *end() {
+        return begin() + size;
+    }
+
+    const Literal *begin() const {
+        return reinterpret_cast<const Literal *>(this + 1);
+    }
+
+    const Literal *end() const {
+        return begin() + size;
+    }
+
+    Literal &operator[](size_t i) {
+        return begin()[i];
+    }
+
+    const Literal &operator[](size_t i) const {
+        return begin()[i];
+    }
+};
+
+static_assert(sizeof(Clause) % sizeof(uint32_t) == 0, "Clause header must be word-aligned");
+
+class ClauseArena {
+public:
+    ClauseArena() = default;
+
+    // Copies the literals into the arena. References obtained before this call may be invalidated.
+    ClauseRef allocate(const std::vector<Literal> &literals, bool learned);
+
+    ClauseRef allocate(const Literal *begin, const Literal *end, bool learned);
+
+    Clause &operator[](ClauseRef ref) {
+        return *reinterpret_cast<Clause *>(&memory[ref]);
+    }
+
+    const Clause &operator[](ClauseRef ref) const {
+        return *reinterpret_cast<const Clause *>(&memory[ref]);
+    }
+
+    // Marks the clause as deleted; its memory is only reclaimed by moving the live clauses to another arena.
+    void free(ClauseRef ref);
+
+    // Moves the clause into the other arena and updates the reference. Moving an already moved clause
+    // yields the same new reference.
+    void relocate(ClauseRef &ref, ClauseArena &to);
+
+    void reserve(size_t words);
+
+    // Size of the arena in 32-bit words.
+    size_t size() const;
+
+    // Words taken by deleted clauses.
+    size_t wasted() const;
+
+    void clear();
+
+private:
+    std::vector<uint32_t> memory;
+    size_t wasted_words = 0;
+};
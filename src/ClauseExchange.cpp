@@ -0,0 +1,91 @@
+#include "ClauseExchange.h"
+
+// Number of clauses kept by the ring buffer of every worker.
+#define SHARED_CAPACITY 4096
+// Clauses longer than binaries are only shared up to this LBD.
+#define SHARED_LBD 2
+// The duplicate filter of a worker is reset once it holds this many hashes.
+#define RECEIVED_LIMIT (1 << 20)
+
+ClauseExchange::ClauseExchange(size_t workers) : readers(workers) {
+    for (size_t worker = 0; worker < workers; worker++) {
+        std::unique_ptr<Ring> ring(new Ring);
+        ring->head.store(0);
+        ring->slots.reset(new Slot[SHARED_CAPACITY]);
+        for (size_t i = 0; i < SHARED_CAPACITY; i++) {
+            ring->slots[i].sequence.store(0);
+            // No clause has this position yet.
+            ring->slots[i].position.store(UINT64_MAX);
+        }
+        rings.push_back(std::move(ring));
+        readers[worker].cursors.assign(workers, 0);
+    }
+}
+
+void ClauseExchange::publish(size_t worker, const std::vector<Literal> &literals, uint32_t lbd) {
+    if (literals.size() > MAX_SHARED_SIZE || (literals.size() > 2 && lbd > SHARED_LBD)) return;
+
+    Ring &ring = *rings[worker];
+    uint64_t position = ring.head.load(std::memory_order_relaxed);
+    Slot &slot = ring.slots[position % SHARED_CAPACITY];
+
+    // Sequence lock: readers discard the slot if the sequence is odd or changes while they read it.
+    uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.position.store(position, std::memory_order_relaxed);
+    slot.size.store(static_cast<uint32_t>(literals.size()), std::memory_order_relaxed);
+    slot.lbd.store(lbd, std::memory_order_relaxed);
+    for (size_t i = 0; i < literals.size(); i++) {
+        slot.literals[i].store(literals[i], std::memory_order_relaxed);
+    }
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+
+    ring.head.store(position + 1, std::memory_order_release);
+}
+
+void ClauseExchange::receive(size_t worker, std::vector<Literal> &buffer) {
+    Reader &reader = readers[worker];
+    Literal literals[MAX_SHARED_SIZE];
+
+    for (size_t source = 0; source < rings.size(); source++) {
+        if (source == worker) continue;
+        Ring &ring = *rings[source];
+        uint64_t head = ring.head.load(std::memory_order_acquire);
+        uint64_t &cursor = reader.cursors[source];
+        if (head - cursor > SHARED_CAPACITY) {
+            cursor = head - SHARED_CAPACITY;
+        }
+
+        for (; cursor < head; cursor++) {
+            Slot &slot = ring.slots[cursor % SHARED_CAPACITY];
+            uint64_t before = slot.sequence.load(std::memory_order_acquire);
+            if (before & 1) continue;
+            uint64_t position = slot.position.load(std::memory_order_relaxed);
+            uint32_t size = slot.size.load(std::memory_order_relaxed);
+            uint32_t lbd = slot.lbd.load(std::memory_order_relaxed);
+            if (size > MAX_SHARED_SIZE) continue;
+            for (uint32_t i = 0; i < size; i++) {
+                literals[i] = slot.literals[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // Overwritten by a newer clause in the meantime.
+            if (slot.sequence.load(std::memory_order_relaxed) != before || position != cursor) continue;
+
+            // The hash doesn't depend on the order of the literals.
+            uint64_t hash = size;
+            for (uint32_t i = 0; i < size; i++) {
+                uint64_t mixed = (literals[i] + 1) * 0x9e3779b97f4a7c15ull;
+                hash += mixed ^ (mixed >> 29);
+            }
+            if (reader.received.size() >= RECEIVED_LIMIT) {
+                reader.received.clear();
+            }
+            if (!reader.received.insert(hash).second) continue;
+
+            buffer.push_back(size);
+            buffer.push_back(lbd);
+            buffer.insert(buffer.end(), literals, literals + size);
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "Literal.h"
+
+// Longest clause that fits into a slot of the exchange.
+#define MAX_SHARED_SIZE 8
+
+// Passes short learned clauses between the workers of a portfolio. Every worker publishes into its own bounded
+// ring buffer, which the other workers read without locking; a reader that falls too far behind skips the
+// overwritten clauses.
+class ClauseExchange {
+public:
+    explicit ClauseExchange(size_t workers);
+
+    ClauseExchange(const ClauseExchange &) = delete;
+
+    ClauseExchange &operator=(const ClauseExchange &) = delete;
+
+    // Shares the clause if it is a unit, a binary or has a low LBD. Only the given worker may publish for itself.
+    void publish(size_t worker, const std::vector<Literal> &literals, uint32_t lbd);
+
+    // Appends the clauses published by the other workers since the last call, each as its size and LBD followed
+    // by its literals. Clauses the worker already received are left out.
+    void receive(size_t worker, std::vector<Literal> &buffer);
+
+private:
+    struct Slot {
+        // Odd while the slot is being written.
+        std::atomic<uint64_t> sequence;
+        // Index of the clause in the ring.
+        std::atomic<uint64_t> position;
+        std::atomic<uint32_t> size;
+        std::atomic<uint32_t> lbd;
+        std::atomic<Literal> literals[MAX_SHARED_SIZE];
+    };
+
+    struct Ring {
+        std::atomic<uint64_t> head;
+        std::unique_ptr<Slot[]> slots;
+    };
+
+    struct Reader {
+        // Next position to read in the ring of every worker.
+        std::vector<uint64_t> cursors;
+        // Hashes of the clauses already received.
+        std::unordered_set<uint64_t> received;
+    };
+
+    std::vector<std::unique_ptr<Ring>> rings;
+    std::vector<Reader> readers;
+};
@@ -0,0 +1,188 @@
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "ClauseExchange.h"
+#include "CubeAndConquer.h"
+#include "Portfolio.h"
+#include "strategies/branching/LookaheadStrategy.h"
+
+namespace {
+
+    // Cubes of every worker. A worker takes its own cubes from the back and steals from the front of the others.
+    class CubeQueues {
+    public:
+        CubeQueues(const std::vector<std::vector<Literal>> &cubes, size_t workers) : queues(workers), mutexes(workers) {
+            for (size_t i = 0; i < cubes.size(); i++) {
+                queues[i % workers].push_back(cubes[i]);
+            }
+        }
+
+        bool take(size_t worker, std::vector<Literal> &cube) {
+            for (size_t offset = 0; offset < queues.size(); offset++) {
+                size_t victim = (worker + offset) % queues.size();
+                std::lock_guard<std::mutex> lock(mutexes[victim]);
+                std::deque<std::vector<Literal>> &queue = queues[victim];
+                if (queue.empty()) continue;
+                if (offset == 0) {
+                    cube = std::move(queue.back());
+                    queue.pop_back();
+                } else {
+                    cube = std::move(queue.front());
+                    queue.pop_front();
+                }
+                return true;
+            }
+            return false;
+        }
+
+    private:
+        std::vector<std::deque<std::vector<Literal>>> queues;
+        std::vector<std::mutex> mutexes;
+    };
+}
+
+std::vector<std::vector<Literal>> CubeAndConquer::generate_cubes(Formula &formula, bool &sat) const {
+    std::vector<std::vector<Literal>> cubes;
+    sat = false;
+    if (formula.empty_clause) return cubes;
+
+    LookaheadStrategy strategy;
+    strategy.initialize(formula);
+    for (const ClauseRef &ref: formula.clauses) {
+        const Clause &clause = formula.arena[ref];
+        if (clause.size != 1) continue;
+        if (formula.value(clause[0]) == F) return cubes;
+        if (formula.value(clause[0]) == U) formula.assign(clause[0], ref);
+    }
+
+    // Depth-first over both polarities of every lookahead decision. `flipped` tells whether the decision at
+    // every level is already the second branch.
+    std::vector<Literal> decisions;
+    std::vector<bool> flipped;
+    while (true) {
+        // There can be up to 2^depth cubes, so listing them is bound by the limits of the search too.
+        if (formula.limit_reached()) {
+            formula.backtrack(0);
+            formula.stopped = true;
+            cubes.clear();
+            return cubes;
+        }
+        bool conflict = formula.propagate() != CLAUSE_NONE;
+        if (!conflict && formula.trail.size() + formula.eliminated_count == formula.variables_count()) {
+            formula.extend_model();
+            sat = true;
+            cubes.assign(1, decisions);
+            return cubes;
+        }
+        if (!conflict && decisions.size() < depth) {
+            Literal decision = strategy.choose(formula);
+            decisions.push_back(decision);
+            flipped.push_back(false);
+            formula.open_level(decision);
+            continue;
+        }
+        if (!conflict) {
+            cubes.push_back(decisions);
+        }
+
+        // Move on to the next unexplored branch.
+        while (!flipped.empty() && flipped.back()) {
+            decisions.pop_back();
+            flipped.pop_back();
+        }
+        if (decisions.empty()) break;
+        formula.backtrack(static_cast<uint32_t>(decisions.size() - 1));
+        decisions.back() = negate(decisions.back());
+        flipped.back() = true;
+        formula.open_level(decisions.back());
+    }
+    formula.backtrack(0);
+    return cubes;
+}
+
+bool CubeAndConquer::solve(Formula &formula) const {
+    bool sat;
+    std::vector<std::vector<Literal>> cubes = generate_cubes(formula, sat);
+    if (sat) return true;
+    if (formula.stopped) return false;
+    // Lookahead refuted every branch.
+    if (cubes.empty()) {
+        formula.empty_clause = true;
+        return false;
+    }
+
+    CubeQueues queues(cubes, threads);
+    std::atomic<bool> finished(false);
+    std::atomic<size_t> running(threads);
+    std::mutex result_mutex;
+    bool answered = false;
+    bool stopped = false;
+    std::vector<LiteralValue> model;
+    std::vector<LiteralValue> best_phases;
+    size_t best_size = 0;
+    SearchStats stats;
+    ClauseExchange exchange(threads);
+
+    auto work = [&](size_t worker) {
+        WorkerConfiguration config = Portfolio::configuration(worker, restart_policy);
+        Formula copy = Portfolio::make_worker_copy(formula, worker, config, finished, exchange);
+        // The cubes may mention any variable.
+        copy.allow_elimination = false;
+        VSIDSStrategy strategy(config.decay_factor, config.seed, config.initial_phase);
+        auto restarts = make_restart_strategy(config.restart_policy, config.luby_unit);
+
+        std::vector<Literal> cube;
+        while (!finished.load() && queues.take(worker, cube)) {
+            bool result = copy.solve(strategy, *restarts, cube);
+            // A refuted cube only matters if the refutation doesn't depend on it.
+            if (!result && !copy.empty_clause && !copy.stopped) continue;
+
+            std::lock_guard<std::mutex> lock(result_mutex);
+            stats.add(copy.stats);
+            // A cube left unsolved leaves the formula undecided, unless another worker decides it.
+            if (copy.stopped) {
+                stopped = true;
+                if (copy.best_size > best_size) {
+                    best_phases = copy.best_phases;
+                    best_size = copy.best_size;
+                }
+                return;
+            }
+            if (finished.exchange(true)) return;
+            answered = true;
+            sat = result;
+            if (sat) {
+                model = std::move(copy.values);
+            }
+            return;
+        }
+        std::lock_guard<std::mutex> lock(result_mutex);
+        stats.add(copy.stats);
+        // Told to finish with cubes possibly left, which then can't count as refuted.
+        if (finished.load()) stopped = true;
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_t worker = 0; worker < threads; worker++) {
+        workers.emplace_back([&, worker]() {
+            work(worker);
+            running--;
+        });
+    }
+    Portfolio::join(workers, running, finished, formula.interrupt);
+    formula.stats.add(stats);
+
+    if (sat) {
+        formula.values = std::move(model);
+    } else if (answered || !stopped) {
+        // Either a refutation or every cube refuted.
+        formula.empty_clause = true;
+    } else {
+        formula.stopped = true;
+        // Workers stopped between cubes leave no phases.
+        if (best_size > 0) formula.best_phases = std::move(best_phases);
+    }
+    return sat;
+}
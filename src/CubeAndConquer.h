@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+
+#include "Formula.h"
+#include "strategies/restart/RestartStrategy.h"
+
+// Splits the formula into cubes with a lookahead strategy and solves them on a pool of worker threads. Each worker
+// keeps one solver and solves its cubes as assumptions, reusing the learned clauses; idle workers steal cubes
+// from the others. The first satisfiable cube ends the run.
+class CubeAndConquer {
+public:
+    // Splits into up to 2^depth cubes.
+    CubeAndConquer(size_t threads, size_t depth, RestartPolicy restart_policy)
+            : threads(threads), depth(depth), restart_policy(restart_policy) {}
+
+    // Solves the formula and copies the model of the satisfiable cube into it.
+    bool solve(Formula &formula) const;
+
+    // Returns the cubes that could not be refuted by propagation. A cube that assigns every variable is the only
+    // one returned and leaves its model in the formula. None are returned if a limit stops the formula first.
+    std::vector<std::vector<Literal>> generate_cubes(Formula &formula, bool &sat) const;
+
+private:
+    size_t threads;
+    size_t depth;
+    RestartPolicy restart_policy;
+};
@@ -0,0 +1,497 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+
+#include "DimacsParser.h"
+
+#define CHUNK_SIZE (1 << 20)
+
+// Largest DIMACS variable that still leaves room for both of its literals in a Literal.
+#define MAX_VARIABLE (LITERAL_NONE / 2 - 1)
+
+namespace {
+
+    // Raw bytes of the input file: the whole file at once when it can be mapped, otherwise consecutive chunks.
+    // Input that is already in memory is taken as it is.
+    class RawInput {
+    public:
+        RawInput(const char *data, size_t size, const std::string &name) : path(name), known_size(size) {
+            pending_begin = reinterpret_cast<const uint8_t *>(data);
+            pending_end = pending_begin + size;
+        }
+
+        explicit RawInput(const std::string &path) : path(path) {
+            if (path == "-") {
+                fd = STDIN_FILENO;
+            } else {
+                fd = open(path.c_str(), O_RDONLY);
+                if (fd < 0) {
+                    throw ParseError("cannot open " + path + ": " + std::strerror(errno));
+                }
+            }
+
+            struct stat status{};
+            if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+                void *memory = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (memory != MAP_FAILED) {
+                    madvise(memory, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+                    mapped = static_cast<const uint8_t *>(memory);
+                    mapped_size = static_cast<size_t>(status.st_size);
+                    known_size = mapped_size;
+                    pending_begin = mapped;
+                    pending_end = mapped + mapped_size;
+                    return;
+                }
+            }
+
+            // Read until the magic bytes can be recognized, a pipe may deliver fewer bytes per read.
+            buffer.resize(CHUNK_SIZE);
+            size_t filled = 0;
+            while (filled < 6) {
+                size_t count = read_some(buffer.data() + filled, buffer.size() - filled);
+                if (count == 0) break;
+                filled += count;
+            }
+            pending_begin = buffer.data();
+            pending_end = buffer.data() + filled;
+        }
+
+        RawInput(const RawInput &) = delete;
+
+        RawInput &operator=(const RawInput &) = delete;
+
+        ~RawInput() {
+            if (mapped != nullptr) {
+                munmap(const_cast<uint8_t *>(mapped), mapped_size);
+            }
+            if (fd >= 0 && fd != STDIN_FILENO) {
+                close(fd);
+            }
+        }
+
+        // Bytes available before the first call to next().
+        const uint8_t *peek_begin() const {
+            return pending_begin;
+        }
+
+        const uint8_t *peek_end() const {
+            return pending_end;
+        }
+
+        // Returns false at the end of the input.
+        bool next(const uint8_t *&begin, const uint8_t *&end) {
+            if (pending_begin != pending_end) {
+                begin = pending_begin;
+                end = pending_end;
+                pending_begin = pending_end = nullptr;
+                return true;
+            }
+            if (mapped != nullptr || fd < 0) return false;
+
+            size_t count = read_some(buffer.data(), buffer.size());
+            if (count == 0) return false;
+            begin = buffer.data();
+            end = buffer.data() + count;
+            return true;
+        }
+
+        const std::string &name() const {
+            return path;
+        }
+
+        // Size of the whole input if it is known before reading it, else 0.
+        size_t size() const {
+            return known_size;
+        }
+
+    private:
+        std::string path;
+        size_t known_size = 0;
+        int fd = -1;
+        const uint8_t *mapped = nullptr;
+        size_t mapped_size = 0;
+        std::vector<uint8_t> buffer;
+        const uint8_t *pending_begin = nullptr;
+        const uint8_t *pending_end = nullptr;
+
+        size_t read_some(uint8_t *destination, size_t size) {
+            ssize_t count;
+            do {
+                count = read(fd, destination, size);
+            } while (count < 0 && errno == EINTR);
+            if (count < 0) {
+                throw ParseError("cannot read " + path + ": " + std::strerror(errno));
+            }
+            return static_cast<size_t>(count);
+        }
+    };
+
+    enum Compression {
+        NONE, GZIP, XZ
+    };
+
+    Compression detect_compression(const uint8_t *begin, const uint8_t *end) {
+        static const uint8_t gzip_magic[] = {0x1f, 0x8b};
+        static const uint8_t xz_magic[] = {0xfd, '7', 'z', 'X', 'Z', 0x00};
+        auto size = static_cast<size_t>(end - begin);
+        if (size >= sizeof(gzip_magic) && std::memcmp(begin, gzip_magic, sizeof(gzip_magic)) == 0) return GZIP;
+        if (size >= sizeof(xz_magic) && std::memcmp(begin, xz_magic, sizeof(xz_magic)) == 0) return XZ;
+        return NONE;
+    }
+
+    // Decompressed text of the input. Uncompressed input is passed through without copying.
+    class TextInput {
+    public:
+        explicit TextInput(RawInput &raw) : raw(raw) {
+            compression = detect_compression(raw.peek_begin(), raw.peek_end());
+            switch (compression) {
+                case NONE:
+                    break;
+                case GZIP:
+#ifdef HAVE_ZLIB
+                    std::memset(&gzip, 0, sizeof(gzip));
+                    // Only accept the gzip wrapper.
+                    if (inflateInit2(&gzip, 15 + 16) != Z_OK) {
+                        throw ParseError("cannot initialize gzip decompression");
+                    }
+                    break;
+#else
+                    throw ParseError(raw.name() + " is gzip compressed, but gzip support is not built in");
+#endif
+                case XZ:
+#ifdef HAVE_LZMA
+                    xz = LZMA_STREAM_INIT;
+                    if (lzma_stream_decoder(&xz, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+                        throw ParseError("cannot initialize xz decompression");
+                    }
+                    break;
+#else
+                    throw ParseError(raw.name() + " is xz compressed, but xz support is not built in");
+#endif
+            }
+            if (compression != NONE) {
+                output.resize(CHUNK_SIZE);
+            }
+        }
+
+        TextInput(const TextInput &) = delete;
+
+        TextInput &operator=(const TextInput &) = delete;
+
+        ~TextInput() {
+#ifdef HAVE_ZLIB
+            if (compression == GZIP) inflateEnd(&gzip);
+#endif
+#ifdef HAVE_LZMA
+            if (compression == XZ) lzma_end(&xz);
+#endif
+        }
+
+        // Size of the whole text if it is known before reading it, else 0.
+        size_t size() const {
+            return compression == NONE ? raw.size() : 0;
+        }
+
+        // Returns false at the end of the input.
+        bool next(const char *&begin, const char *&end) {
+            if (compression == NONE) {
+                const uint8_t *raw_begin, *raw_end;
+                if (!raw.next(raw_begin, raw_end)) return false;
+                begin = reinterpret_cast<const char *>(raw_begin);
+                end = reinterpret_cast<const char *>(raw_end);
+                return true;
+            }
+
+            while (true) {
+                if (input_begin == input_end && !input_finished) {
+                    input_finished = !raw.next(input_begin, input_end);
+                }
+                size_t produced = decompress();
+                if (produced > 0) {
+                    begin = reinterpret_cast<const char *>(output.data());
+                    end = begin + produced;
+                    return true;
+                }
+                if (stream_finished && input_begin == input_end && input_finished) return false;
+                if (input_finished && input_begin == input_end) {
+                    throw ParseError(raw.name() + " ends in the middle of a compressed stream");
+                }
+            }
+        }
+
+    private:
+        RawInput &raw;
+        Compression compression = NONE;
+        std::vector<uint8_t> output;
+        const uint8_t *input_begin = nullptr;
+        const uint8_t *input_end = nullptr;
+        bool input_finished = false;
+        bool stream_finished = false;
+#ifdef HAVE_ZLIB
+        z_stream gzip{};
+#endif
+#ifdef HAVE_LZMA
+        lzma_stream xz = LZMA_STREAM_INIT;
+#endif
+
+        // Decompresses the pending input into the output buffer and returns the number of bytes produced.
+        size_t decompress() {
+#ifdef HAVE_ZLIB
+            if (compression == GZIP) {
+                if (stream_finished && input_begin != input_end) {
+                    // Concatenated gzip members form a single file.
+                    inflateReset(&gzip);
+                    stream_finished = false;
+                }
+                if (stream_finished) return 0;
+                gzip.next_in = const_cast<Bytef *>(input_begin);
+                gzip.avail_in = static_cast<uInt>(std::min<size_t>(input_end - input_begin, UINT32_MAX));
+                gzip.next_out = output.data();
+                gzip.avail_out = static_cast<uInt>(output.size());
+                int status = inflate(&gzip, Z_NO_FLUSH);
+                if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+                    throw ParseError(raw.name() + ": corrupt gzip data");
+                }
+                stream_finished = status == Z_STREAM_END;
+                input_begin = gzip.next_in;
+                return output.size() - gzip.avail_out;
+            }
+#endif
+#ifdef HAVE_LZMA
+            if (compression == XZ) {
+                if (stream_finished) return 0;
+                xz.next_in = input_begin;
+                xz.avail_in = static_cast<size_t>(input_end - input_begin);
+                xz.next_out = output.data();
+                xz.avail_out = output.size();
+                lzma_ret status = lzma_code(&xz, input_finished ? LZMA_FINISH : LZMA_RUN);
+                if (status != LZMA_OK && status != LZMA_STREAM_END && status != LZMA_BUF_ERROR) {
+                    throw ParseError(raw.name() + ": corrupt xz data");
+                }
+                stream_finished = status == LZMA_STREAM_END;
+                input_begin = xz.next_in;
+                return output.size() - xz.avail_out;
+            }
+#endif
+            return 0;
+        }
+    };
+
+    class Scanner {
+    public:
+        Scanner(TextInput &input, const std::string &name) : input(input), name(name) {}
+
+        // Returns the current character, or EOF at the end of the input.
+        int peek() {
+            if (position == end) {
+                if (!input.next(position, end)) return EOF;
+                characters_read += static_cast<size_t>(end - position);
+            }
+            return static_cast<unsigned char>(*position);
+        }
+
+        // Characters of the text read so far, up to the end of the current chunk.
+        size_t characters() const {
+            return characters_read;
+        }
+
+        void advance() {
+            position++;
+        }
+
+        // Skips spaces and line breaks.
+        void skip_whitespace() {
+            int c;
+            while ((c = peek()) != EOF && (c == ' ' || c == '\t' || c == '\n' || c == '\r')) {
+                if (c == '\n') line++;
+                advance();
+            }
+        }
+
+        void skip_line() {
+            int c;
+            while ((c = peek()) != EOF && c != '\n') {
+                advance();
+            }
+        }
+
+        void expect(const char *word) {
+            for (; *word != '\0'; word++) {
+                if (peek() != static_cast<unsigned char>(*word)) {
+                    fail(std::string("expected '") + word + "'");
+                }
+                advance();
+            }
+        }
+
+        // Reads an optionally negative integer whose absolute value must not exceed the limit.
+        long read_integer(unsigned long limit) {
+            int c = peek();
+            bool negative = c == '-';
+            if (negative) {
+                advance();
+                c = peek();
+            }
+            if (c < '0' || c > '9') fail("expected a number");
+
+            unsigned long value = 0;
+            do {
+                value = 10 * value + static_cast<unsigned long>(c - '0');
+                if (value > limit) fail("number out of range");
+                advance();
+                c = peek();
+            } while (c >= '0' && c <= '9');
+
+            auto result = static_cast<long>(value);
+            return negative ? -result : result;
+        }
+
+        [[noreturn]] void fail(const std::string &message) const {
+            throw ParseError(name + ":" + std::to_string(line) + ": " + message);
+        }
+
+    private:
+        TextInput &input;
+        const std::string &name;
+        const char *position = nullptr;
+        const char *end = nullptr;
+        size_t line = 1;
+        size_t characters_read = 0;
+    };
+
+    // Reads the problem line and the clauses into the sink, which takes them through the same methods as a Formula.
+    template<typename Sink>
+    void parse_into(RawInput &raw, Sink &sink) {
+        TextInput text(raw);
+        Scanner scanner(text, raw.name());
+
+        bool header_seen = false;
+        size_t declared_variables = 0;
+        std::vector<Literal> literals;
+
+        while (true) {
+            scanner.skip_whitespace();
+            int c = scanner.peek();
+            if (c == EOF) break;
+
+            if (c == 'c') {
+                scanner.skip_line();
+            } else if (c == 'p') {
+                if (header_seen) scanner.fail("duplicate problem line");
+                header_seen = true;
+                scanner.advance();
+                scanner.skip_whitespace();
+                scanner.expect("cnf");
+                scanner.skip_whitespace();
+                long variables_count = scanner.read_integer(MAX_VARIABLE);
+                scanner.skip_whitespace();
+                long clauses_count = scanner.read_integer(UINT32_MAX);
+                if (variables_count < 0 || clauses_count < 0) scanner.fail("negative count in the problem line");
+                // The counts are only trusted as far as the input can hold that many variables and clauses, each of
+                // which takes at least two characters.
+                size_t limit = text.size() / 2;
+                declared_variables = static_cast<size_t>(variables_count);
+                if (declared_variables <= limit) sink.set_variables_count(declared_variables);
+                sink.set_clauses_count(std::min(static_cast<size_t>(clauses_count), limit));
+            } else if (c == '%') {
+                // Terminator used by the SATLIB benchmarks, everything after it is ignored.
+                break;
+            } else if (c == '-' || (c >= '0' && c <= '9')) {
+                if (!header_seen) scanner.fail("clause before the problem line");
+                long dimacs_literal = scanner.read_integer(MAX_VARIABLE);
+                if (dimacs_literal == 0) {
+                    sink.add_clause(literals);
+                    literals.clear();
+                } else {
+                    Literal literal = from_dimacs(dimacs_literal);
+                    // Variables missing from the header are accepted.
+                    if (var_of(literal) >= sink.variables_count()) {
+                        sink.set_variables_count(var_of(literal) + 1);
+                    }
+                    literals.push_back(literal);
+                }
+            } else {
+                scanner.fail(std::string("unexpected character '") + static_cast<char>(c) + "'");
+            }
+        }
+
+        // The last clause may lack its terminating zero.
+        if (!literals.empty()) {
+            sink.add_clause(literals);
+        }
+        // Declared variables that don't occur are kept, within the same bound once the size of the input is known.
+        if (declared_variables <= scanner.characters() / 2) {
+            sink.set_variables_count(declared_variables);
+        }
+    }
+
+    // Passes everything read on to a formula and to a copy of the clauses as they were read.
+    class TeeSink {
+    public:
+        TeeSink(Formula &formula, Cnf &cnf) : formula(formula), cnf(cnf) {}
+
+        size_t variables_count() const {
+            return formula.variables_count();
+        }
+
+        void set_variables_count(size_t n) {
+            formula.set_variables_count(n);
+            cnf.set_variables_count(n);
+        }
+
+        void set_clauses_count(size_t n) {
+            formula.set_clauses_count(n);
+            cnf.set_clauses_count(n);
+        }
+
+        void add_clause(const std::vector<Literal> &clause) {
+            cnf.add_clause(clause);
+            formula.add_clause(clause);
+        }
+
+    private:
+        Formula &formula;
+        Cnf &cnf;
+    };
+}
+
+void DimacsParser::parse(const std::string &path, Formula &formula) {
+    RawInput raw(path);
+    parse_into(raw, formula);
+}
+
+void DimacsParser::parse(const std::string &path, Cnf &cnf) {
+    RawInput raw(path);
+    parse_into(raw, cnf);
+}
+
+void DimacsParser::parse(const std::string &path, Formula &formula, Cnf &cnf) {
+    RawInput raw(path);
+    TeeSink sink(formula, cnf);
+    parse_into(raw, sink);
+}
+
+void DimacsParser::parse_text(const std::string &text, const std::string &name, Formula &formula) {
+    RawInput raw(text.data(), text.size(), name);
+    parse_into(raw, formula);
+}
+
+void DimacsParser::parse_text(const std::string &text, const std::string &name, Formula &formula, Cnf &cnf) {
+    RawInput raw(text.data(), text.size(), name);
+    TeeSink sink(formula, cnf);
+    parse_into(raw, sink);
+}
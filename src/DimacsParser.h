@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Formula.h"
+
+class ParseError : public std::runtime_error {
+public:
+    explicit ParseError(const std::string &message) : std::runtime_error(message) {}
+};
+
+// Clauses exactly as they are read, duplicate literals and tautologies included, stored one after the other.
+struct Cnf {
+    std::vector<Literal> literals;
+    // Position in `literals` past the last literal of every clause.
+    std::vector<size_t> clause_ends;
+    size_t variables = 0;
+
+    size_t variables_count() const {
+        return variables;
+    }
+
+    void set_variables_count(size_t n) {
+        variables = std::max(variables, n);
+    }
+
+    void set_clauses_count(size_t n) {
+        clause_ends.reserve(n);
+    }
+
+    void add_clause(const std::vector<Literal> &clause) {
+        literals.insert(literals.end(), clause.begin(), clause.end());
+        clause_ends.push_back(literals.size());
+    }
+};
+
+// Reads DIMACS CNF into a formula, or into a plain list of clauses. Regular files are memory-mapped, pipes and
+// standard input ("-") are read in chunks, and gzip or xz compressed input is recognized by its magic bytes and
+// decompressed while parsing.
+class DimacsParser {
+public:
+    // Throws ParseError if the input cannot be read or is malformed.
+    static void parse(const std::string &path, Formula &formula);
+
+    static void parse(const std::string &path, Cnf &cnf);
+
+    // Also keeps the clauses as they are read in `cnf`, for input that can't be read twice.
+    static void parse(const std::string &path, Formula &formula, Cnf &cnf);
+
+    // Parses input that is already in memory, compressed or not. The name only appears in error messages.
+    static void parse_text(const std::string &text, const std::string &name, Formula &formula);
+
+    static void parse_text(const std::string &text, const std::string &name, Formula &formula, Cnf &cnf);
+};
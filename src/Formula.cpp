@@ -1,489 +1,1004 @@
 #include <algorithm>
 #include <cassert>
-#include <deque>
 #include <iostream>
 #include <string>
-#include <sstream>
 
+#include "ClauseExchange.h"
 #include "Formula.h"
-#include "strategies/branching/BranchingStrategy.h"
+#include "Inprocessor.h"
+#include "LocalSearch.h"
+#include "Profile.h"
+#include "strategies/branching/VSIDSStrategy.h"
+#include "strategies/restart/AlternatingStrategy.h"
 
+#ifndef ASSERT
 #define ASSERT false
+#endif
 
-std::vector<std::string> split(const std::string &str, char delim) {
-    std::vector<std::string> items;
-    std::stringstream str_stream(str);
-    std::string item;
-    while (std::getline(str_stream, item, delim)) {
-        if (!item.empty()) items.push_back(item);
-    }
-    return items;
-}
+// Learned clauses with an LBD up to CORE_LBD are kept forever, those up to TIER2_LBD survive reductions
+// as long as they keep taking part in conflicts.
+#define CORE_LBD 2
+#define TIER2_LBD 6
+
+#define CLAUSE_DECAY 0.999f
+#define CLAUSE_RESCALE_LIMIT 1e20f
+
+#define REPHASE_INTERVAL 1000
+#define WALK_FLIPS_PER_CONFLICT 30
+
+#define INPROCESSING_INTERVAL 10000
+
+// Search iterations between looking at the clock and the memory usage.
+#define LIMIT_CHECK_INTERVAL 256
 
 void Formula::set_variables_count(size_t n) {
-//    variables.reserve(n);
+    if (n <= variables_count()) return;
+    values.resize(n, U);
+    implicated_by.resize(n, CLAUSE_NONE);
+    levels.resize(n, 0);
+    saved_phases.resize(n, U);
+    target_phases.resize(n, U);
+    best_phases.resize(n, U);
+    seen.resize(n, 0);
+    eliminated.resize(n, 0);
+    unit_ids.resize(n, 0);
+    occurrences.resize(2 * n);
+    watches.resize(2 * n);
 }
 
 void Formula::set_clauses_count(size_t n) {
-//    clauses.reserve(n);
+    clauses.reserve(n);
 }
 
-void Formula::add_clause(const std::string &clause_str) {
-    std::vector<std::string> clause_str_vec = split(clause_str, ' ');
-    std::vector<long> clause_vec;
-    for (const auto &str_literal: clause_str_vec) {
-        if (str_literal != "0") {
-            clause_vec.push_back(std::stol(str_literal));
-        } else {
-            add_clause(clause_vec);
-            break;
+// Duplicate literals are dropped and tautologies are skipped; the variables must already be allocated and can't
+// be eliminated. Between searches, the clause is also simplified by the top-level assignment.
+void Formula::add_clause(const std::vector<Literal> &clause_literals) {
+    if (decision_level() > 0) backtrack(0);
+    // Input clauses are numbered in the order they are read, including the dropped ones.
+    uint64_t id = logging() ? proof->input_clause() : 0;
+
+    std::vector<Literal> &literals = clause_buffer;
+    literals.clear();
+    bool tautology = false;
+    for (const Literal &literal: clause_literals) {
+        if (ASSERT) assert(var_of(literal) < variables_count() && !eliminated[var_of(literal)]);
+        // The analysis marks are free outside of conflicts; 1 + polarity records the literal seen first.
+        uint8_t &mark = seen[var_of(literal)];
+        if (mark == 0) {
+            mark = 1 + is_negative(literal);
+            literals.push_back(literal);
+        } else if (mark != 1 + is_negative(literal)) {
+            tautology = true;
+        }
+    }
+    for (const Literal &literal: literals) {
+        seen[var_of(literal)] = 0;
+    }
+    // Tautologies are always satisfied.
+    if (tautology) return;
+
+    size_t input_size = literals.size();
+    if (!trail.empty()) {
+        size_t kept = 0;
+        for (const Literal &literal: literals) {
+            LiteralValue literal_value = value(literal);
+            if (literal_value == T) return;
+            if (literal_value == U) literals[kept++] = literal;
         }
+        literals.resize(kept);
     }
+    if (literals.size() < input_size) log_addition(literals.data(), literals.data() + literals.size());
 
+    if (literals.empty()) {
+        // An empty input clause refutes the formula by itself.
+        if (input_size == 0 && logging()) proof->add(nullptr, nullptr, std::vector<uint64_t>(1, id));
+        empty_clause = true;
+        return;
+    }
+
+    ClauseRef ref = arena.allocate(literals, false);
+    if (lrat()) set_clause_id(ref, id);
+    for (const Literal &literal: literals) {
+        occurrences[literal].push_back(ref);
+    }
+    if (literals.size() >= 2) {
+        attach_clause(ref);
+    }
+    clauses.push_back(ref);
 }
 
-void Formula::add_clause(const std::vector<long> &clause_vec) {
-    auto *clause = new Clause{{},
-                              {}};
-    for (const long &new_literal: clause_vec) {
-        if (ASSERT) assert(new_literal != 0);
-        if (std::find_if(clause->literals.cbegin(), clause->literals.cend(),
-                         [&](const auto &literal) {
-                             return literal.variable->id == std::abs(new_literal);
-                         }) == clause->literals.end()) {
+// The first literal of the learned clause is the asserted one, the second one has the highest level among the rest.
+// In LRAT proofs, the clause follows from the hints collected last.
+ClauseRef Formula::add_learned_clause(const std::vector<Literal> &literals, uint32_t lbd) {
+    ClauseRef ref = arena.allocate(literals, true);
+    if (logging()) {
+        uint64_t id = proof->add(literals.data(), literals.data() + literals.size(), hints);
+        if (lrat()) set_clause_id(ref, id);
+    }
+    Clause &clause = arena[ref];
+    clause.lbd = lbd;
+    bump_clause(clause);
 
-            auto it = std::find_if(variables.begin(), variables.end(),
-                                   [&](const auto &variable) {
-                                       return variable->id == std::abs(new_literal);
-                                   });
+    if (clause.size >= 2) {
+        attach_clause(ref);
+    }
+    learned_clauses.push_back(ref);
+    return ref;
+}
 
-            if (it == variables.end()) {
-                auto *variable = new Variable{std::abs(new_literal), U, nullptr, {}, {}, 0, 0};
-                if (new_literal > 0) {
-                    variable->positive_occurrences.push_back(clause);
-                    clause->literals.emplace_back(1, variable);
+void Formula::attach_clause(ClauseRef ref) {
+    const Clause &clause = arena[ref];
+    if (ASSERT) assert(clause.size >= 2);
+    bool binary = clause.size == 2;
+    watches[clause[0]].push_back({ref, clause[1], binary});
+    watches[clause[1]].push_back({ref, clause[0], binary});
+}
+
+// First-UIP conflict analysis. Resolves the conflict clause with the reasons of the literals assigned at the
+// current decision level, walking the trail backwards, until a single literal of the current level remains.
+// The returned clause starts with the negation of that literal, followed by the literal of the highest remaining
+// level, which is also the level to backjump to.
+template<typename Branching>
+const std::vector<Literal> &
+Formula::register_conflict(ClauseRef conflict_clause, uint32_t &backjump_level, uint32_t &lbd, Branching &strategy) {
+    learned.clear();
+    // Placeholder for the asserted literal.
+    learned.push_back(LITERAL_NONE);
+
+    size_t pending = 0;
+    Literal uip = LITERAL_NONE;
+    size_t index = trail.size();
+    ClauseRef reason = conflict_clause;
+
+    do {
+        if (ASSERT) assert(reason != CLAUSE_NONE);
+        Clause &clause = arena[reason];
+        if (clause.learned) {
+            bump_clause(clause);
+            clause.used = true;
+            // Clauses that keep connecting fewer levels move up to a better tier.
+            if (clause.lbd > CORE_LBD) {
+                clause.lbd = std::min(clause.lbd, compute_lbd(clause.begin(), clause.end()));
+            }
+        }
+        // The literal implied by a reason is first in long clauses, but either one in binary clauses.
+        for (size_t i = 0; i < clause.size; i++) {
+            Literal literal = clause[i];
+            if (literal == uip) continue;
+            Var variable = var_of(literal);
+            if (ASSERT) assert(value(literal) == F);
+            if (!seen[variable] && levels[variable] > 0) {
+                seen[variable] = 1;
+                strategy.bump(literal);
+                if (levels[variable] >= decision_level()) {
+                    pending++;
                 } else {
-                    variable->negative_occurrences.push_back(clause);
-                    clause->literals.emplace_back(-1, variable);
+                    learned.push_back(literal);
                 }
-                variables.push_back(variable);
+            }
+        }
+
+        // Select the next literal of the current level to resolve on.
+        while (!seen[var_of(trail[--index])]);
+        uip = trail[index];
+        reason = implicated_by[var_of(uip)];
+        seen[var_of(uip)] = 0;
+        pending--;
+    } while (pending > 0);
+    learned[0] = negate(uip);
+
+    // Drop the literals implied by the rest of the clause.
+    analyze_to_clear.assign(learned.begin(), learned.end());
+    uint32_t abstract_levels = 0;
+    for (size_t i = 1; i < learned.size(); i++) {
+        abstract_levels |= 1u << (levels[var_of(learned[i])] & 31);
+    }
+    size_t kept = 1;
+    for (size_t i = 1; i < learned.size(); i++) {
+        if (implicated_by[var_of(learned[i])] == CLAUSE_NONE || !literal_redundant(learned[i], abstract_levels)) {
+            learned[kept++] = learned[i];
+        }
+    }
+    learned.resize(kept);
+
+    for (const Literal &literal: analyze_to_clear) {
+        seen[var_of(literal)] = 0;
+    }
+
+    // Watch the literal that gets unassigned last, the clause becomes unit at its level.
+    backjump_level = 0;
+    for (size_t i = 1; i < learned.size(); i++) {
+        if (levels[var_of(learned[i])] > backjump_level) {
+            backjump_level = levels[var_of(learned[i])];
+            std::swap(learned[1], learned[i]);
+        }
+    }
+    lbd = compute_lbd(learned.data(), learned.data() + learned.size());
+    return learned;
+}
+
+// Checks whether the literal is implied by the literals marked as seen, following the reasons recursively.
+// Levels outside of the abstraction of the learned clause can't lead back to it, so their reasons are not followed.
+bool Formula::literal_redundant(Literal literal, uint32_t abstract_levels) {
+    analyze_stack.clear();
+    analyze_stack.push_back(literal);
+    size_t top = analyze_to_clear.size();
+
+    while (!analyze_stack.empty()) {
+        Var implied = var_of(analyze_stack.back());
+        const Clause &clause = arena[implicated_by[implied]];
+        analyze_stack.pop_back();
+
+        for (size_t i = 0; i < clause.size; i++) {
+            Literal reason_literal = clause[i];
+            Var variable = var_of(reason_literal);
+            if (variable == implied || seen[variable] || levels[variable] == 0) continue;
+
+            if (implicated_by[variable] != CLAUSE_NONE && (abstract_levels & (1u << (levels[variable] & 31)))) {
+                seen[variable] = 1;
+                analyze_stack.push_back(reason_literal);
+                analyze_to_clear.push_back(reason_literal);
             } else {
-                if (new_literal > 0) {
-                    (*it)->positive_occurrences.push_back(clause);
-                    clause->literals.emplace_back(1, (*it));
-                } else {
-                    (*it)->negative_occurrences.push_back(clause);
-                    clause->literals.emplace_back(-1, (*it));
+                for (size_t j = top; j < analyze_to_clear.size(); j++) {
+                    seen[var_of(analyze_to_clear[j])] = 0;
                 }
+                analyze_to_clear.resize(top);
+                return false;
             }
         }
     }
+    return true;
+}
 
-    if (clause->literals.size() >= 1) {
-        clause->watched.first = *clause->literals.begin();
+// Literal block distance: the number of distinct decision levels among the literals.
+uint32_t Formula::compute_lbd(const Literal *begin, const Literal *end) {
+    if (level_stamps.size() <= decision_level()) {
+        level_stamps.resize(decision_level() + 1, 0);
     }
-    if (clause->literals.size() >= 2) {
-        clause->watched.second = *std::next(clause->literals.begin());
+    lbd_stamp++;
+    uint32_t lbd = 0;
+    for (const Literal *literal = begin; literal != end; literal++) {
+        uint32_t level = levels[var_of(*literal)];
+        if (level_stamps[level] != lbd_stamp) {
+            level_stamps[level] = lbd_stamp;
+            lbd++;
+        }
     }
-
-    clauses.push_back(clause);
+    return lbd;
 }
 
-void Formula::add_learned_clause(const std::unordered_set<SignedVariable, hash_sv> &clause_vec) {
-    auto *clause = new Clause{{},
-                              {}};
-    for (const SignedVariable &new_literal: clause_vec) {
-        // Variables in a learned clause can't be unassigned at the time of adding.
-        if (ASSERT) assert(new_literal.variable->value != U);
-        // Variables in a learned clause cannot satisfy this clause
-        if (ASSERT)
-            assert(new_literal.variable->value == T && new_literal.sign < 0 ||
-                   new_literal.variable->value == F && new_literal.sign > 0);
-        if (new_literal.sign > 0) {
-            new_literal.variable->positive_occurrences.push_back(clause);
-            new_literal.variable->negative_conflicts++;
-        } else if (new_literal.sign < 0) {
-            new_literal.variable->negative_occurrences.push_back(clause);
-            new_literal.variable->positive_conflicts++;
+void Formula::bump_clause(Clause &clause) {
+    clause.activity += clause_increment;
+    if (clause.activity > CLAUSE_RESCALE_LIMIT) {
+        for (const ClauseRef &ref: learned_clauses) {
+            arena[ref].activity /= CLAUSE_RESCALE_LIMIT;
         }
-        clause->literals.push_back(new_literal);
+        clause.activity /= CLAUSE_RESCALE_LIMIT;
+        clause_increment /= CLAUSE_RESCALE_LIMIT;
     }
+}
 
-    if (clause->literals.size() >= 1) {
-        clause->watched.first = *clause->literals.begin();
+// A clause that is the reason of a current assignment can't be deleted.
+bool Formula::locked(ClauseRef ref) const {
+    const Clause &clause = arena[ref];
+    for (size_t i = 0; i < (clause.size == 2 ? 2 : 1); i++) {
+        if (value(clause[i]) == T && implicated_by[var_of(clause[i])] == ref) return true;
     }
-    if (clause->literals.size() >= 2) {
-        clause->watched.second = *std::next(clause->literals.begin());
+    return false;
+}
+
+// Deletes the less useful half of the learned clauses outside of the core and the recently used tier 2.
+void Formula::reduce_learned_clauses() {
+    ProfileTimer timer(stats.reduction_time);
+    std::vector<ClauseRef> candidates;
+    size_t kept = 0;
+    for (const ClauseRef &ref: learned_clauses) {
+        Clause &clause = arena[ref];
+        bool protected_tier = clause.lbd <= CORE_LBD || (clause.lbd <= TIER2_LBD && clause.used);
+        clause.used = false;
+        if (protected_tier || locked(ref)) {
+            learned_clauses[kept++] = ref;
+        } else {
+            candidates.push_back(ref);
+        }
+    }
+    learned_clauses.resize(kept);
+
+    std::sort(candidates.begin(), candidates.end(), [&](const ClauseRef &left, const ClauseRef &right) {
+        const Clause &left_clause = arena[left];
+        const Clause &right_clause = arena[right];
+        if (left_clause.lbd != right_clause.lbd) return left_clause.lbd > right_clause.lbd;
+        return left_clause.activity < right_clause.activity;
+    });
+    size_t deleted = candidates.size() / 2;
+    stats.deleted_clauses += static_cast<long>(deleted);
+    for (size_t i = 0; i < candidates.size(); i++) {
+        if (i < deleted) {
+            log_deletion(candidates[i]);
+            arena.free(candidates[i]);
+        } else {
+            learned_clauses.push_back(candidates[i]);
+        }
     }
 
-    clauses.push_back(clause);
-}
+    // Detach the deleted clauses.
+    for (auto &watchers: watches) {
+        watchers.erase(std::remove_if(watchers.begin(), watchers.end(), [&](const Watcher &watcher) {
+            return arena[watcher.ref].deleted;
+        }), watchers.end());
+    }
 
-std::unordered_set<SignedVariable, hash_sv>
-Formula::register_conflict(Variable *variable, Clause *implicated_by_left, Clause *implicated_by_right) {
-    if (implicated_by_left != nullptr && implicated_by_right != nullptr) {
-        std::unordered_set<SignedVariable, hash_sv> conflict;
-        std::unordered_set<Variable *> visited;
-        std::deque<SignedVariable> traversal_queue;
+    if (arena.wasted() > arena.size() / 5) {
+        collect_garbage();
+    }
+}
 
-        for (const auto &implicated_by_literal: implicated_by_left->literals) {
-            if (implicated_by_literal.variable != variable) {
-                assert(implicated_by_literal.variable->value != U &&
-                       (implicated_by_literal.variable->value == T && implicated_by_literal.sign < 0) ||
-                       (implicated_by_literal.variable->value == F && implicated_by_literal.sign > 0));
-                if (visited.find(implicated_by_literal.variable) == visited.end()) {
-                    traversal_queue.push_back(implicated_by_literal);
-                    visited.insert(implicated_by_literal.variable);
-                }
+// Compacts the arena by moving every live clause into the spare one and updating all references to them.
+void Formula::collect_garbage() {
+    ClauseArena &compacted = spare_arena;
+    compacted.clear();
+    compacted.reserve(arena.size() - arena.wasted());
+
+    // Clause ids are indexed by reference; every live clause is in one of the clause lists.
+    std::vector<uint64_t> ids;
+    if (lrat()) {
+        for (const auto *ref_list: {&clauses, &learned_clauses}) {
+            for (const ClauseRef &ref: *ref_list) {
+                ids.push_back(clause_ids[ref]);
             }
         }
+    }
 
-        for (const auto &implicated_by_literal: implicated_by_right->literals) {
-            if (implicated_by_literal.variable != variable) {
-                assert(implicated_by_literal.variable->value != U &&
-                       (implicated_by_literal.variable->value == T && implicated_by_literal.sign < 0) ||
-                       (implicated_by_literal.variable->value == F && implicated_by_literal.sign > 0));
-                if (visited.find(implicated_by_literal.variable) == visited.end()) {
-                    traversal_queue.push_back(implicated_by_literal);
-                    visited.insert(implicated_by_literal.variable);
-                }
+    for (auto &watchers: watches) {
+        for (auto &watcher: watchers) {
+            arena.relocate(watcher.ref, compacted);
+        }
+    }
+    for (const Literal &literal: trail) {
+        ClauseRef &reason = implicated_by[var_of(literal)];
+        if (reason != CLAUSE_NONE) {
+            arena.relocate(reason, compacted);
+        }
+    }
+    for (auto &ref: clauses) {
+        arena.relocate(ref, compacted);
+    }
+    for (auto &ref_list: occurrences) {
+        for (auto &ref: ref_list) {
+            arena.relocate(ref, compacted);
+        }
+    }
+    for (auto &ref: learned_clauses) {
+        arena.relocate(ref, compacted);
+    }
+
+    std::swap(arena, spare_arena);
+    spare_arena.clear();
+
+    if (lrat()) {
+        clause_ids.assign(arena.size(), 0);
+        size_t i = 0;
+        for (const auto *ref_list: {&clauses, &learned_clauses}) {
+            for (const ClauseRef &ref: *ref_list) {
+                clause_ids[ref] = ids[i++];
             }
         }
+    }
+}
 
-        while (!traversal_queue.empty()) {
-            SignedVariable literal = traversal_queue.front();
+void Formula::decide(Literal literal) {
+    stats.decisions++;
+    open_level(literal);
+}
 
-            // Found a UIP, return it immediately
-            if (traversal_queue.size() == 1 && conflict.empty()) {
-                conflict = {literal};
-                break;
+void Formula::open_level(Literal literal) {
+    trail_limits.push_back(trail.size());
+    assign(literal, CLAUSE_NONE);
+}
+
+void Formula::assign(Literal literal, ClauseRef reason) {
+    // Can't assign an empty literal.
+    if (ASSERT) assert(literal != LITERAL_NONE);
+    if (ASSERT) assert(values[var_of(literal)] == U);
+
+    new_iterations++;
+    assignments_count++;
+    Var variable = var_of(literal);
+    values[variable] = is_negative(literal) ? F : T;
+    implicated_by[variable] = reason;
+    levels[variable] = decision_level();
+    trail.push_back(literal);
+}
+
+// Propagates every pending literal on the trail. Returns the falsified clause on conflict.
+ClauseRef Formula::propagate() {
+    ProfileTimer timer(stats.propagation_time);
+    while (propagation_head < trail.size()) {
+        Literal falsified = negate(trail[propagation_head++]);
+        stats.propagations++;
+        // Only the clauses watching the falsified literal need to be visited.
+        std::vector<Watcher> &watchers = watches[falsified];
+
+        size_t kept = 0;
+        for (size_t i = 0; i < watchers.size(); i++) {
+            Watcher watcher = watchers[i];
+            LiteralValue blocker_value = value(watcher.blocker);
+            if (blocker_value == T) {
+                watchers[kept++] = watcher;
+                continue;
             }
 
-            if (literal.variable->implicated_by == nullptr) {
-                if (conflict.find(literal) == conflict.end()) {
-                    conflict.insert(literal);
+            Literal implied = watcher.blocker;
+            if (!watcher.binary) {
+                Clause &clause = arena[watcher.ref];
+                // Keep the falsified literal in the second watched position.
+                if (clause[0] == falsified) {
+                    std::swap(clause[0], clause[1]);
                 }
-            } else {
-                for (const auto &implicated_by_literal: literal.variable->implicated_by->literals) {
-                    if (visited.find(implicated_by_literal.variable) == visited.end()) {
-                        traversal_queue.push_back(implicated_by_literal);
-                        visited.insert(implicated_by_literal.variable);
-                    }
+                implied = clause[0];
+                if (implied != watcher.blocker && value(implied) == T) {
+                    watchers[kept++] = {watcher.ref, implied, false};
+                    continue;
                 }
-            }
-            traversal_queue.pop_front();
-        }
-
-        for (const auto &clause: clauses) {
-            if (clause->literals.size() == conflict.size()) {
-                bool seen_clause = true;
-                auto clause_it = clause->literals.begin();
-                auto conflict_it = conflict.begin();
-                while (conflict_it != conflict.end()) {
-                    if ((*clause_it).variable != (*conflict_it).variable ||
-                        (*clause_it).sign != (*conflict_it).sign) {
-                        seen_clause = false;
+
+                // Attempt to watch something new.
+                bool moved = false;
+                for (size_t j = 2; j < clause.size; j++) {
+                    if (value(clause[j]) != F) {
+                        std::swap(clause[1], clause[j]);
+                        watches[clause[1]].push_back({watcher.ref, implied, false});
+                        moved = true;
                         break;
                     }
-                    clause_it++;
-                    conflict_it++;
                 }
-                if (seen_clause) return {};
+                if (moved) continue;
+                watcher.blocker = implied;
+                blocker_value = value(implied);
             }
+
+            watchers[kept++] = watcher;
+            if (blocker_value == F) {
+                // Both of the watchers are dead.
+                for (i++; i < watchers.size(); i++) {
+                    watchers[kept++] = watchers[i];
+                }
+                watchers.resize(kept);
+                propagation_head = trail.size();
+                return watcher.ref;
+            }
+            assign(implied, watcher.ref);
         }
+        watchers.resize(kept);
+    }
+    return CLAUSE_NONE;
+}
 
-        add_learned_clause(conflict);
-        new_conflicts++;
-        return conflict;
+void Formula::backtrack(uint32_t level) {
+    backtrack(level, branching_strategy);
+}
+
+// Rewinds the trail to the given decision level, touching only the undone assignments.
+template<typename Branching>
+void Formula::backtrack(uint32_t level, Branching *strategy) {
+    if (level >= decision_level()) return;
+
+    size_t level_start = trail_limits[level];
+    for (size_t i = trail.size(); i > level_start; i--) {
+        Var variable = var_of(trail[i - 1]);
+        saved_phases[variable] = values[variable];
+        values[variable] = U;
+        implicated_by[variable] = CLAUSE_NONE;
+        // Preprocessing probes before a strategy is attached.
+        if (strategy != nullptr) strategy->unassigned(variable);
     }
-    return {};
+    trail.resize(level_start);
+    trail_limits.resize(level);
+    propagation_head = std::min(propagation_head, trail.size());
 }
 
-// We are assuming that the literal appears in some unit clause
-bool Formula::propagate(SignedVariable literal, Clause *implicated_by, bool retry) {
-    // Can't propagate an empty variable.
-    if (ASSERT) assert(literal.sign != 0);
-    if (ASSERT) assert(literal.variable != nullptr);
+template<typename Branching, typename Restarts>
+void Formula::restart(Branching &strategy, Restarts &restarts) {
+    // Workers of a portfolio only import shared clauses at the top level, so they always go all the way back.
+    uint32_t level = exchange == nullptr ? strategy.restart_level(*this) : 0;
+    backtrack(level, &strategy);
+    new_conflicts = 0;
+    restarts_count++;
+    stats.restarts++;
+    restarts.restarted(*this);
+}
 
-    new_iterations++;
-    choices.emplace_back(retry, literal);
-    literal.variable->implicated_by = implicated_by;
-
-    if (literal.sign > 0) {
-        literal.variable->value = T;
-        for (const auto &positive_occurrence: literal.variable->positive_occurrences) {
-            if (positive_occurrence->watched.first.variable != literal.variable) {
-                positive_occurrence->watched.first = literal;
-            } else if (positive_occurrence->watched.second.variable != literal.variable) {
-                positive_occurrence->watched.second = literal;
-            }
+// Returns true if we were able to recover from the conflict.
+template<typename Branching, typename Restarts>
+bool Formula::handle_conflict(ClauseRef clause, Branching &strategy, Restarts &restarts) {
+    // A conflict that doesn't depend on any decision proves the formula unsatisfiable.
+    if (decision_level() == 0) {
+        return false;
+    }
+    ProfileTimer timer(stats.analysis_time);
+    stats.conflicts++;
+    stats.conflict_trail_sum += static_cast<long>(trail.size());
+
+    // Conflict encountered, time to register it.
+    uint32_t backjump_level, lbd;
+    const std::vector<Literal> &cut = register_conflict(clause, backjump_level, lbd, strategy);
+    if (lrat()) collect_hints(clause, cut);
+    if (exchange != nullptr) {
+        exchange->publish(exchange_worker, cut, lbd);
+    }
+    strategy.decay();
+    restarts.conflict(*this, lbd);
+    // Everything below the conflicting level was assigned without a conflict.
+    update_target_phases(trail_limits.back());
+    clause_increment /= CLAUSE_DECAY;
+    conflicts_count++;
+    new_conflicts++;
+    stats.learned_clauses++;
+    stats.learned_lbd_sum += lbd;
+
+    // Jump straight to the level where the learned clause becomes unit and assert its UIP literal there.
+    backtrack(backjump_level, &strategy);
+    ClauseRef learned_clause = add_learned_clause(cut, lbd);
+    assign(arena[learned_clause][0], learned_clause);
+    return true;
+}
+
+// Adds the clauses learned by the other workers, simplified by the top-level assignment. Returns false if one
+// of them is falsified.
+bool Formula::import_shared_clauses() {
+    if (ASSERT) assert(decision_level() == 0);
+    shared_buffer.clear();
+    exchange->receive(exchange_worker, shared_buffer);
+
+    size_t i = 0;
+    while (i < shared_buffer.size()) {
+        uint32_t size = shared_buffer[i];
+        uint32_t lbd = shared_buffer[i + 1];
+        const Literal *literals = &shared_buffer[i + 2];
+        i += 2 + size;
+
+        // Clauses over variables this worker has substituted since are skipped along with the satisfied ones.
+        clause_buffer.clear();
+        bool skipped = false;
+        for (uint32_t j = 0; j < size && !skipped; j++) {
+            LiteralValue literal_value = value(literals[j]);
+            skipped = literal_value == T || eliminated[var_of(literals[j])];
+            if (literal_value == U) clause_buffer.push_back(literals[j]);
         }
-        return check_clauses(literal.variable->negative_occurrences);
-    } else if (literal.sign < 0) {
-        literal.variable->value = F;
-        for (const auto &negative_occurrence: literal.variable->negative_occurrences) {
-            if (negative_occurrence->watched.first.variable != literal.variable) {
-                negative_occurrence->watched.first = literal;
-            } else if (negative_occurrence->watched.second.variable != literal.variable) {
-                negative_occurrence->watched.second = literal;
-            }
+        if (skipped) continue;
+
+        if (clause_buffer.empty()) return false;
+        if (clause_buffer.size() == 1) {
+            log_addition(clause_buffer.data(), clause_buffer.data() + 1);
+            assign(clause_buffer[0], CLAUSE_NONE);
+        } else {
+            add_learned_clause(clause_buffer, std::min(lbd, static_cast<uint32_t>(clause_buffer.size())));
         }
-        return check_clauses(literal.variable->positive_occurrences);
     }
-    assert(false);
+    return true;
 }
 
-SignedVariable Formula::find_new_watched(Clause *clause) {
-    for (const auto &literal: clause->literals) {
-        bool unassigned_variable = literal.variable->value == U;
-        bool satisfying_variable = (literal.variable->value == T && literal.sign > 0) ||
-                                   (literal.variable->value == F && literal.sign < 0);
-        if ((unassigned_variable || satisfying_variable) &&
-            literal.variable != clause->watched.first.variable &&
-            literal.variable != clause->watched.second.variable) {
-            return literal;
+// Searches for a model in which the assumptions hold. Returns false with the empty clause flag set if there is no
+// model at all, and without it if there is none under the assumptions. Learned clauses are kept across calls.
+bool Formula::solve(BranchingStrategy &strategy, RestartStrategy &restarts, const std::vector<Literal> &assumptions) {
+    stopped = false;
+    failed_assumptions.clear();
+    if (empty_clause) return false;
+
+    // A later call starts over from the top level, keeping the state of the strategy.
+    if (branching_strategy != &strategy) {
+        branching_strategy = nullptr;
+        backtrack(0);
+        branching_strategy = &strategy;
+        branching_strategy->initialize(*this);
+    } else {
+        backtrack(0);
+        if (strategy_variables_count < variables_count()) {
+            branching_strategy->variables_added(*this);
+        }
+    }
+    strategy_variables_count = variables_count();
+    if (restart_strategy != &restarts) {
+        restart_strategy = &restarts;
+        restart_strategy->initialize(*this);
+    }
+    new_conflicts = 0;
+    if (eliminated_count > 0) {
+        for (Var variable = 0; variable < variables_count(); variable++) {
+            if (eliminated[variable]) values[variable] = U;
         }
     }
-    return {0, nullptr};
-}
 
-Choice Formula::find_conflicting_choice(Clause *dead_clause) {
-    for (const auto &choice: choices) {
-        for (const auto &literal: dead_clause->literals) {
-            if (choice.literal.variable == literal.variable &&
-                choice.literal.sign != literal.sign) {
-                return choice;
+    for (const ClauseRef &ref: clauses) {
+        const Clause &clause = arena[ref];
+        if (clause.size == 1) {
+            if (value(clause[0]) == F) {
+                refute(ref);
+                return false;
             }
+            if (value(clause[0]) == U) assign(clause[0], ref);
         }
     }
-    return {false, {0, nullptr}};
+
+    // The strategies the solver ships with get a search of their own, any others go through their interfaces.
+    auto *vsids = dynamic_cast<VSIDSStrategy *>(&strategy);
+    if (vsids != nullptr) {
+        if (auto *alternating = dynamic_cast<AlternatingStrategy *>(&restarts)) {
+            return search(*vsids, *alternating, assumptions);
+        }
+        if (auto *glucose = dynamic_cast<GlucoseStrategy *>(&restarts)) return search(*vsids, *glucose, assumptions);
+        if (auto *luby = dynamic_cast<LubyStrategy *>(&restarts)) return search(*vsids, *luby, assumptions);
+    }
+    return search(strategy, restarts, assumptions);
 }
 
-bool Formula::non_chronological_backtrack(const std::unordered_set<SignedVariable, hash_sv> &cut) {
-    bool backtracked = false;
-    while (!choices.empty()) {
-        // Non-chronological backtrack.
-        for (const auto &literal: cut) {
-            if (choices.back().literal == literal) {
-                backtracked = true;
+template<typename Branching, typename Restarts>
+bool Formula::search(Branching &strategy, Restarts &restarts, const std::vector<Literal> &assumptions) {
+    while (true) {
+        if (limit_reached()) {
+            // Everything before the propagation head was propagated without a conflict.
+            update_target_phases(propagation_head);
+            stopped = true;
+            return false;
+        }
+
+        ClauseRef conflict = propagate();
+        if (conflict != CLAUSE_NONE) {
+            if (!handle_conflict(conflict, strategy, restarts)) {
+                refute(conflict);
+                return false;
+            }
+            continue;
+        }
+
+        // Every variable is assigned without a conflict, so every clause is satisfied.
+        if (trail.size() + eliminated_count == variables_count()) {
+            for (const Literal &assumption: assumptions) {
+                if (value(assumption) == F) {
+                    analyze_final(assumption);
+                    return false;
+                }
+            }
+            extend_model();
+            return true;
+        }
+
+        if (restarts.should_restart(*this)) {
+            restart(strategy, restarts);
+        }
+        if (conflicts_count >= next_rephase) {
+            // Phases are saved on unassignment, so the new ones only take effect for unassigned variables.
+            backtrack(0, &strategy);
+            rephase();
+        }
+        // Inprocessing doesn't produce LRAT hints.
+        if (conflicts_count >= next_inprocessing && !lrat()) {
+            backtrack(0, &strategy);
+            ProfileTimer timer(stats.inprocessing_time);
+            if (!Inprocessor(*this).inprocess(assignments_count - inprocessed_assignments)) return false;
+            inprocessed_assignments = assignments_count;
+            next_inprocessing = conflicts_count + INPROCESSING_INTERVAL * (inprocessing_stats.rounds + 1);
+            // The new top-level assignments still have to be checked for a model.
+            continue;
+        }
+
+        // Clauses of the other workers are only added at the top level, where none of them can be conflicting.
+        if (exchange != nullptr && decision_level() == 0) {
+            size_t assigned = trail.size();
+            if (!import_shared_clauses()) {
+                refute(CLAUSE_NONE);
+                return false;
+            }
+            if (trail.size() > assigned) continue;
+        }
+
+        if (conflicts_count >= next_reduction) {
+            reduce_learned_clauses();
+            reduction_interval += reduction_increment;
+            next_reduction = conflicts_count + reduction_interval;
+        }
+
+        if (new_iterations > 65536) {
+            if (verbose) print();
+            new_iterations = 0;
+        }
+
+        // The assumptions are the first decisions, one level each, so that they are redone after every restart.
+        Literal decision = LITERAL_NONE;
+        while (decision_level() < assumptions.size()) {
+            Literal assumption = assumptions[decision_level()];
+            if (value(assumption) == F) {
+                analyze_final(assumption);
+                return false;
+            }
+            if (value(assumption) == U) {
+                decision = assumption;
                 break;
             }
+            // Already implied, the level stays empty.
+            trail_limits.push_back(trail.size());
         }
-        Choice last_choice = choices.back();
-        depropagate(last_choice.literal);
-        choices.pop_back();
-        if (backtracked) break;
-    }
 
-    return backtracked;
+        // Choose a literal to branch on.
+        if (decision == LITERAL_NONE) {
+            decision = strategy.choose(*this);
+        }
+        // Nothing left to branch on, the model is taken the next time round.
+        if (decision == LITERAL_NONE) {
+            if (ASSERT) assert(trail.size() + eliminated_count == variables_count());
+            continue;
+        }
+        decide(decision);
+    }
 }
 
-bool Formula::backtrack() {
-    while (!choices.empty() && !choices.back().retry) {
-        Choice last_choice = choices.back();
-        depropagate(last_choice.literal);
-        choices.pop_back();
-    }
-    // Exhausted our space
-    if (choices.empty()) {
-        return false;
-    } else {
-        Choice last_choice = choices.back();
-        depropagate(last_choice.literal);
-        if (ASSERT) assert(last_choice.retry);
-        if (ASSERT) assert(last_choice.literal.variable->implicated_by == nullptr);
-        SignedVariable new_literal = {-last_choice.literal.sign, last_choice.literal.variable};
-        choices.pop_back();
-        propagate(new_literal, nullptr, false);
-        return true;
+// Collects the assumptions that imply the negation of the given falsified one, following the reasons back to
+// the assumptions decided on the way.
+void Formula::analyze_final(Literal falsified) {
+    failed_assumptions.clear();
+    failed_assumptions.push_back(falsified);
+    if (decision_level() == 0) return;
+
+    seen[var_of(falsified)] = 1;
+    for (size_t i = trail.size(); i > trail_limits[0]; i--) {
+        Var variable = var_of(trail[i - 1]);
+        if (!seen[variable]) continue;
+        seen[variable] = 0;
+
+        ClauseRef reason = implicated_by[variable];
+        if (reason == CLAUSE_NONE) {
+            // Below the assumption levels every decision is an assumption.
+            failed_assumptions.push_back(trail[i - 1]);
+            continue;
+        }
+        const Clause &clause = arena[reason];
+        for (size_t j = 0; j < clause.size; j++) {
+            if (var_of(clause[j]) != variable && levels[var_of(clause[j])] > 0) seen[var_of(clause[j])] = 1;
+        }
     }
+    seen[var_of(falsified)] = 0;
 }
 
-void Formula::random_restart() {
-    if (new_conflicts >= current_ceiling) {
-        while (!choices.empty()) {
-            Choice last_choice = choices.back();
-            depropagate(last_choice.literal);
-            choices.pop_back();
+// Assigns the eliminated variables by replaying the elimination stack backwards: a stored clause whose other
+// literals are all false makes its first literal true.
+void Formula::extend_model() {
+    size_t i = elimination_stack.size();
+    while (i > 0) {
+        size_t size = elimination_stack[--i];
+        i -= size;
+        const Literal *clause = &elimination_stack[i];
+
+        bool satisfied = false;
+        for (size_t j = 1; j < size && !satisfied; j++) {
+            satisfied = value(clause[j]) == T;
         }
-        new_conflicts = 0;
-        if (current_ceiling == absolute_ceiling) {
-            current_ceiling = 1;
-            absolute_ceiling *= 2;
-        } else {
-            current_ceiling *= 2;
+        if (!satisfied) {
+            values[var_of(clause[0])] = is_negative(clause[0]) ? F : T;
         }
     }
 }
 
-void Formula::decay(double decay_factor) {
-    if (new_iterations > 65536) {
-        print();
-        for (const auto &variable: variables) {
-            variable->positive_conflicts *= decay_factor;
-            variable->negative_conflicts *= decay_factor;
-        }
-        new_iterations = 0;
-    };
+// Polarity a decision on the variable should take, U if it has never been assigned.
+LiteralValue Formula::preferred_phase(Var variable) const {
+    if (restart_strategy != nullptr && restart_strategy->stable() && target_phases[variable] != U) {
+        return target_phases[variable];
+    }
+    return saved_phases[variable];
 }
 
-// Returns true if we were able to recover from the conflict.
-bool Formula::handle_conflict(Clause *clause) {
-    // Conflict encountered, time to register it.
-    Choice conflicting_choice = find_conflicting_choice(clause);
-    std::unordered_set<SignedVariable, hash_sv> cut =
-            register_conflict(conflicting_choice.literal.variable,
-                              conflicting_choice.literal.variable->implicated_by,
-                              clause);
-    if (cut.empty()) {
-        if (!backtrack()) {
-            return false;
+// Records the first `size` literals of the trail as target and best phases if they make a longer trail.
+void Formula::update_target_phases(size_t size) {
+    if (size > target_size) {
+        for (size_t i = 0; i < size; i++) {
+            Var variable = var_of(trail[i]);
+            target_phases[variable] = values[variable];
         }
-    } else {
-        if (!non_chronological_backtrack(cut)) {
-            return false;
+        target_size = size;
+    }
+    if (size > best_size) {
+        for (size_t i = 0; i < size; i++) {
+            Var variable = var_of(trail[i]);
+            best_phases[variable] = values[variable];
         }
+        best_size = size;
     }
-    return true;
 }
 
-bool Formula::check_all_satisfied() {
-    for (const auto &clause: clauses) {
-        bool first_watched_satisfies =
-                clause->watched.first.variable->value == T && clause->watched.first.sign > 0 ||
-                clause->watched.first.variable->value == F && clause->watched.first.sign < 0;
-        bool second_watched_satisfies =
-                clause->watched.second.variable->value == T && clause->watched.second.sign > 0 ||
-                clause->watched.second.variable->value == F && clause->watched.second.sign < 0;
-        if (first_watched_satisfies || second_watched_satisfies) {
-            continue;
+// Overwrites the saved phases to move the search to another part of the space. The best and walk phases come back
+// every third time. A model found by the walk is found by the search right after, without any conflict.
+void Formula::rephase() {
+    static const Rephase cycle[] = {REPHASE_BEST, REPHASE_WALK, REPHASE_ORIGINAL, REPHASE_BEST, REPHASE_WALK,
+                                    REPHASE_INVERTED, REPHASE_BEST, REPHASE_WALK, REPHASE_RANDOM};
+    switch (cycle[rephases_count % (sizeof(cycle) / sizeof(cycle[0]))]) {
+        case REPHASE_BEST:
+            for (Var variable = 0; variable < variables_count(); variable++) {
+                if (best_phases[variable] != U) saved_phases[variable] = best_phases[variable];
+            }
+            std::fill(best_phases.begin(), best_phases.end(), U);
+            best_size = 0;
+            break;
+        case REPHASE_ORIGINAL:
+            std::fill(saved_phases.begin(), saved_phases.end(), U);
+            break;
+        case REPHASE_INVERTED:
+            for (auto &phase: saved_phases) {
+                if (phase != U) phase = phase == T ? F : T;
+            }
+            break;
+        case REPHASE_RANDOM:
+            for (auto &phase: saved_phases) {
+                phase = random() & 1 ? T : F;
+            }
+            break;
+        case REPHASE_WALK: {
+            // The walk starts from the saved phases and gets as many flips as the last conflicts allow.
+            LocalSearch local_search(*this, static_cast<unsigned>(random()));
+            local_search.interrupt = interrupt;
+            local_search.deadline = limits.deadline;
+            local_search.walk(saved_phases, WALK_FLIPS_PER_CONFLICT * (conflicts_count - last_rephase));
+            const std::vector<LiteralValue> &walk_phases = local_search.best_phases();
+            for (Var variable = 0; variable < variables_count(); variable++) {
+                if (walk_phases[variable] != U) saved_phases[variable] = walk_phases[variable];
+            }
+            break;
         }
-        return false;
     }
-    return true;
+    std::fill(target_phases.begin(), target_phases.end(), U);
+    target_size = 0;
+    rephases_count++;
+    last_rephase = conflicts_count;
+    next_rephase = conflicts_count + REPHASE_INTERVAL * (rephases_count + 1);
 }
 
-bool Formula::check_clauses(const std::list<Clause *> &clauses_to_check) {
-    // Perform boolean constraint propagation.
-    for (auto &clause: clauses_to_check) {
-        // If we can no longer hold on to the literals.
-        if (clause->literals.size() >= 2 && (clause->watched.first.variable->value != U ||
-                                             clause->watched.second.variable->value != U)) {
-            // Check whether one of the watched variables satisfies the clause.
-            bool first_watched_satisfies =
-                    clause->watched.first.variable->value == T && clause->watched.first.sign > 0 ||
-                    clause->watched.first.variable->value == F && clause->watched.first.sign < 0;
-            bool second_watched_satisfies =
-                    clause->watched.second.variable->value == T && clause->watched.second.sign > 0 ||
-                    clause->watched.second.variable->value == F && clause->watched.second.sign < 0;
-            if (first_watched_satisfies || second_watched_satisfies) {
-                continue;
-            } else {
-                // The first watched variable has died, attempt to watch something new.
-                if (clause->watched.first.variable->value != U) {
-                    SignedVariable watched_candidate = find_new_watched(clause);
-                    // Found a new variable to watch!
-                    if (watched_candidate.variable != nullptr) {
-                        clause->watched.first = watched_candidate;
-                    }
-                }
-                // The second watched variable has died, attempt to watch something new.
-                if (clause->watched.second.variable->value != U) {
-                    SignedVariable watched_candidate = find_new_watched(clause);
-                    // Found a new variable to watch!
-                    if (watched_candidate.variable != nullptr) {
-                        clause->watched.second = watched_candidate;
-                    }
-                }
+// The counts are checked on every call, the clock and the memory only every LIMIT_CHECK_INTERVAL calls.
+bool Formula::limit_reached() {
+    if (interrupt != nullptr && interrupt->load(std::memory_order_relaxed)) return true;
+    if (stats.conflicts >= limits.conflicts || stats.propagations >= limits.propagations ||
+        stats.decisions >= limits.decisions) {
+        return true;
+    }
+    if (++unchecked_iterations < LIMIT_CHECK_INTERVAL) return false;
+    unchecked_iterations = 0;
+    return std::chrono::steady_clock::now() >= limits.deadline || memory_usage() > limits.memory;
+}
 
-                // Check whether one of the watched variables satisfies the clause after the reassignment.
-                first_watched_satisfies =
-                        clause->watched.first.variable->value == T && clause->watched.first.sign > 0 ||
-                        clause->watched.first.variable->value == F && clause->watched.first.sign < 0;
-                second_watched_satisfies =
-                        clause->watched.second.variable->value == T && clause->watched.second.sign > 0 ||
-                        clause->watched.second.variable->value == F && clause->watched.second.sign < 0;
+// Every clause of two or more literals has two watchers.
+size_t Formula::memory_usage() const {
+    return arena.size() * sizeof(uint32_t) + 2 * (clauses.size() + learned_clauses.size()) * sizeof(Watcher);
+}
 
-                if (first_watched_satisfies || second_watched_satisfies) {
-                    continue;
-                } else if (clause->watched.first.variable->value != U &&
-                           clause->watched.second.variable->value != U) {
-                    // If both of the watchers are dead.
-                    if (!handle_conflict(clause)) {
-                        return false;
-                    }
-                    break;
-                } else if (clause->watched.first.variable->value != U &&
-                           clause->watched.second.variable->value == U) {
-                    if (!propagate(clause->watched.second, clause, false)) {
-                        return false;
-                    }
-                } else if (clause->watched.second.variable->value != U &&
-                           clause->watched.first.variable->value == U) {
-                    if (!propagate(clause->watched.first, clause, false)) {
-                        return false;
-                    }
-                }
-            }
-        } else if (clause->literals.size() == 1) {
-            if (clause->watched.first.variable->value == U) {
-                if (!propagate(clause->watched.first, clause, false)) {
-                    return false;
-                }
-            } else if (clause->watched.first.variable->value == T && clause->watched.first.sign < 0 ||
-                       clause->watched.first.variable->value == F && clause->watched.first.sign > 0) {
-                if (!handle_conflict(clause)) {
-                    return false;
-                }
-                break;
-            } else {
-                continue;
-            }
-        }
-        // We disallow empty clauses.
-        if (ASSERT) assert(!clause->literals.empty());
+// Progress goes to standard error, standard output only gets the result.
+void Formula::print() {
+    std::cerr << "# CLAUSES: " << clauses.size()
+              << " # LEARNED: " << learned_clauses.size()
+              << " # TRAIL: " << trail.size()
+              << " # DECISIONS: " << stats.decisions
+              << " # PROPAGATIONS: " << stats.propagations
+              << " # CONFLICTS: " << conflicts_count
+              << " # RESTARTS: " << restarts_count
+              << " # AVERAGE LBD: " << static_cast<double>(stats.learned_lbd_sum) / std::max(1L, stats.learned_clauses)
+              << (restart_strategy != nullptr && restart_strategy->stable() ? " # STABLE" : " # FOCUSED")
+              << " # NEW ITERATIONS: " << new_iterations << std::endl;
+    // The inprocessing totals only change with a new round.
+    if (inprocessing_stats.rounds > printed_rounds) {
+        printed_rounds = inprocessing_stats.rounds;
+        std::cerr << "# INPROCESSING ROUNDS: " << inprocessing_stats.rounds
+                  << " # FAILED LITERALS: " << inprocessing_stats.failed_literals
+                  << " # VIVIFIED: " << inprocessing_stats.vivified_clauses
+                  << " (" << inprocessing_stats.vivified_literals << " literals)"
+                  << " # SUBSTITUTED: " << inprocessing_stats.substituted_variables
+                  << " # SUBSUMED: " << inprocessing_stats.subsumed_clauses
+                  << " # STRENGTHENED: " << inprocessing_stats.strengthened_clauses << std::endl;
     }
-    return true;
 }
 
-bool Formula::solve(const BranchingStrategy &branching_strategy) {
-    while (true) {
-        // Luby restarts.
-        random_restart();
-        decay(0.95);
+void Formula::log_addition(const Literal *begin, const Literal *end) {
+    if (logging()) proof->add(begin, end);
+}
 
-        if (!check_clauses(clauses)) return false;
+// Unit clauses are never deleted: simplification drops them once they are satisfied, but their assignments are
+// still needed by the lemmas after them.
+void Formula::log_deletion(const Literal *begin, const Literal *end) {
+    if (logging() && end - begin != 1) proof->remove(begin, end, 0);
+}
 
-        if (check_all_satisfied()) {
-            return true;
+void Formula::log_deletion(ClauseRef ref) {
+    if (!logging()) return;
+    const Clause &clause = arena[ref];
+    if (clause.size == 1) return;
+    proof->remove(clause.begin(), clause.end(), lrat() ? clause_ids[ref] : 0);
+}
+
+// Logs the top-level assignments not logged yet as unit clauses, so that they outlive the clauses implying them.
+// LRAT steps refer to these units instead of the top-level reasons.
+void Formula::log_units() {
+    if (!logging()) return;
+    size_t top_level_end = decision_level() == 0 ? trail.size() : trail_limits[0];
+    for (; logged_units < top_level_end; logged_units++) {
+        Literal literal = trail[logged_units];
+        Var variable = var_of(literal);
+        if (!lrat()) {
+            proof->add(&literal, &literal + 1);
+            continue;
         }
 
-        // Choose a variable to branch on.
-        const std::pair<Variable *, LiteralValue> assignment = branching_strategy.choose(*this);
-        SignedVariable literal{assignment.second == T ? 1 : -1, assignment.first};
-        propagate(literal, nullptr, true);
+        // Without preprocessing, every top-level assignment has a reason.
+        ClauseRef reason = implicated_by[variable];
+        if (ASSERT) assert(reason != CLAUSE_NONE);
+        const Clause &clause = arena[reason];
+        if (clause.size == 1) {
+            unit_ids[variable] = clause_ids[reason];
+            continue;
+        }
+        hints.clear();
+        for (const Literal &reason_literal: clause) {
+            if (var_of(reason_literal) != variable) hints.push_back(unit_ids[var_of(reason_literal)]);
+        }
+        hints.push_back(clause_ids[reason]);
+        unit_ids[variable] = proof->add(&literal, &literal + 1, hints);
     }
 }
 
-void Formula::depropagate(const SignedVariable &eliminated_literal) {
-    eliminated_literal.variable->value = U;
-    eliminated_literal.variable->implicated_by = nullptr;
+// Sets the empty clause flag and logs the empty clause. In LRAT, it follows from the top-level assignment
+// falsifying the given clause.
+void Formula::refute(ClauseRef conflict) {
+    empty_clause = true;
+    if (!logging()) return;
+    if (lrat() && conflict != CLAUSE_NONE) {
+        learned.clear();
+        collect_hints(conflict, learned);
+    }
+    proof->add(nullptr, nullptr, hints);
 }
 
-void Formula::print() const {
-    std::cout << "# CLAUSES: " << clauses.size()
-              << " # CHOICES: " << choices.size()
-              << " # NEW CONFLICTS: " << new_conflicts
-              << " # CURRENT CEILING: " << current_ceiling
-              << " # ABSOLUTE CEILING: " << absolute_ceiling
-              << " # NEW ITERATIONS: " << new_iterations << std::endl;
+void Formula::set_clause_id(ClauseRef ref, uint64_t id) {
+    if (clause_ids.size() < arena.size()) clause_ids.resize(arena.size(), 0);
+    clause_ids[ref] = id;
 }
 
-Formula::~Formula() {
-    for (auto &variable: variables) {
-        delete variable;
+// Collects the LRAT hints of a clause whose negation leads to the conflict by unit propagation over the reasons on
+// the trail: the units of the top-level literals involved, then the reasons of the implied literals in the order
+// of the trail, and the conflicting clause last.
+void Formula::collect_hints(ClauseRef conflict, const std::vector<Literal> &clause) {
+    log_units();
+    hints.clear();
+    hint_variables.clear();
+
+    // 1 marks the variables of the clause, 2 the implied ones whose reasons are needed, and 3 the top-level ones.
+    for (const Literal &literal: clause) {
+        seen[var_of(literal)] = 1;
+        hint_variables.push_back(var_of(literal));
+    }
+    auto require = [&](Literal literal) {
+        Var variable = var_of(literal);
+        if (seen[variable]) return;
+        seen[variable] = levels[variable] == 0 ? 3 : 2;
+        hint_variables.push_back(variable);
+    };
+    for (const Literal &literal: arena[conflict]) {
+        require(literal);
+    }
+    size_t top_level_end = decision_level() == 0 ? trail.size() : trail_limits[0];
+    for (size_t i = trail.size(); i > top_level_end; i--) {
+        Var variable = var_of(trail[i - 1]);
+        if (seen[variable] != 2) continue;
+        ClauseRef reason = implicated_by[variable];
+        if (ASSERT) assert(reason != CLAUSE_NONE);
+        for (const Literal &literal: arena[reason]) {
+            if (var_of(literal) != variable) require(literal);
+        }
+        hints.push_back(clause_ids[reason]);
+    }
+    std::reverse(hints.begin(), hints.end());
+    hints.push_back(clause_ids[conflict]);
+
+    size_t units = 0;
+    for (const Var &variable: hint_variables) {
+        if (seen[variable] == 3) units++;
     }
-    for (auto &clause: clauses) {
-        delete clause;
+    hints.insert(hints.begin(), units, 0);
+    units = 0;
+    for (const Var &variable: hint_variables) {
+        if (seen[variable] == 3) hints[units++] = unit_ids[variable];
+        seen[variable] = 0;
     }
 }
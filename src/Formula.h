@@ -1,144 +1,326 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <climits>
 #include <cmath>
-#include <list>
-#include <unordered_map>
-#include <unordered_set>
+#include <cstdint>
+#include <random>
 #include <vector>
-#include <string>
+
+#include "ClauseArena.h"
+#include "Literal.h"
+#include "Proof.h"
 
 // Forward-declaration
 class BranchingStrategy;
 
-typedef long ID;
-typedef long Sign;
+class ClauseExchange;
+
+class RestartStrategy;
 
-enum LiteralValue {
-    U, T, F
+// Source of the saved phases after a rephase. The original phases are left to the branching strategy, and walk
+// phases are the best assignment found by local search.
+enum Rephase {
+    REPHASE_BEST, REPHASE_ORIGINAL, REPHASE_INVERTED, REPHASE_RANDOM, REPHASE_WALK
 };
 
-struct Clause;
-struct Variable;
+// Entry of a watch list. The blocker is a literal of the clause other than the watched one; if it is true, the
+// clause is satisfied and its memory isn't touched. Binary clauses are propagated from the watcher alone, their
+// blocker being the other literal.
+struct Watcher {
+    ClauseRef ref;
+    Literal blocker;
+    bool binary;
+};
 
-struct SignedVariable {
-    Sign sign;
-    Variable *variable;
+// Work done by inprocessing, summed over all rounds.
+struct InprocessingStats {
+    long rounds = 0;
+    long failed_literals = 0;
+    long vivified_clauses = 0;
+    long vivified_literals = 0;
+    long substituted_variables = 0;
+    long subsumed_clauses = 0;
+    long strengthened_clauses = 0;
+};
 
-    SignedVariable() {
-        this->sign = 0;
-        this->variable = nullptr;
+// Work done by the search. The times are only measured in builds with PROFILE defined.
+struct SearchStats {
+    long decisions = 0;
+    long propagations = 0;
+    long conflicts = 0;
+    long restarts = 0;
+    long learned_clauses = 0;
+    long deleted_clauses = 0;
+    // Sums over the conflicts, of the LBD of the learned clause and of the trail size.
+    long learned_lbd_sum = 0;
+    long conflict_trail_sum = 0;
+    double propagation_time = 0;
+    double analysis_time = 0;
+    double reduction_time = 0;
+    double inprocessing_time = 0;
+
+    void add(const SearchStats &other) {
+        decisions += other.decisions;
+        propagations += other.propagations;
+        conflicts += other.conflicts;
+        restarts += other.restarts;
+        learned_clauses += other.learned_clauses;
+        deleted_clauses += other.deleted_clauses;
+        learned_lbd_sum += other.learned_lbd_sum;
+        conflict_trail_sum += other.conflict_trail_sum;
+        propagation_time += other.propagation_time;
+        analysis_time += other.analysis_time;
+        reduction_time += other.reduction_time;
+        inprocessing_time += other.inprocessing_time;
     }
+};
 
-    SignedVariable(Sign sign, Variable *variable) {
-        this->sign = sign;
-        this->variable = variable;
-    }
+// Limits of the search, which stops without an answer when it reaches one of them. The counts are compared with
+// the search stats of the formula, so they add up over successive searches. Memory is estimated from the clauses
+// and their watches.
+struct SearchLimits {
+    long conflicts = LONG_MAX;
+    long propagations = LONG_MAX;
+    long decisions = LONG_MAX;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    size_t memory = SIZE_MAX;
+};
+
+class Formula {
+public:
+    // All clauses live in the arena; the watched literals of a clause are kept in its first two positions.
+    ClauseArena arena;
+    // Garbage collection compacts the arena into this one and swaps them, so that both keep their memory.
+    ClauseArena spare_arena;
+    std::vector<ClauseRef> clauses;
+    std::vector<ClauseRef> learned_clauses;
+
+    // Per-variable state, indexed by Var.
+    std::vector<LiteralValue> values;
+    std::vector<ClauseRef> implicated_by;
+    std::vector<uint32_t> levels;
+    // Value of the variable when it was last unassigned, U if it has never been assigned.
+    std::vector<LiteralValue> saved_phases;
+    // Assignments of the longest conflict-free trail since the last rephase, preferred over the saved phases in
+    // stable phases, and of the longest one since the best phases were last restored.
+    std::vector<LiteralValue> target_phases;
+    std::vector<LiteralValue> best_phases;
+    size_t target_size = 0;
+    size_t best_size = 0;
+    // Scratch marks used by conflict analysis; all clear in between conflicts.
+    std::vector<uint8_t> seen;
+    // Variables removed by preprocessing; they are never branched on and get their value from extend_model().
+    std::vector<uint8_t> eliminated;
+    size_t eliminated_count = 0;
+
+    // Per-literal state, indexed by Literal.
+    std::vector<std::vector<ClauseRef>> occurrences;
+    std::vector<std::vector<Watcher>> watches;
+
+    // Assignment trail; literals past `propagation_head` have not been propagated yet.
+    std::vector<Literal> trail;
+    size_t propagation_head = 0;
+    // Position in `trail` of every decision, i.e. where each decision level starts.
+    std::vector<size_t> trail_limits;
+
+    // Clauses removed by variable elimination, each followed by its size. The first literal of every clause
+    // belongs to the eliminated variable.
+    std::vector<Literal> elimination_stack;
+
+    bool empty_clause = false;
+
+    // Strategy of the running search, notified about conflicts and unassignments.
+    BranchingStrategy *branching_strategy = nullptr;
+    // Number of variables the strategy knows about.
+    size_t strategy_variables_count = 0;
+    RestartStrategy *restart_strategy = nullptr;
+
+    // Assumptions that made the last search fail, empty if it failed without any.
+    std::vector<Literal> failed_assumptions;
+
+    long conflicts_count = 0;
+    long assignments_count = 0;
+    // Conflicts since the last restart.
+    long new_conflicts = 0;
+    long restarts_count = 0;
+
+    // Conflict count at which the learned clauses are reduced next; the interval grows after every reduction.
+    long next_reduction = 2000;
+    long reduction_interval = 2000;
+    long reduction_increment = 300;
+    float clause_increment = 1;
+
+    // Conflict count at which the saved phases are reset next, following a fixed cycle of rephasing kinds.
+    long next_rephase = 1000;
+    long last_rephase = 0;
+    long rephases_count = 0;
+    std::mt19937 random;
+
+    // Conflict count at which the clause database is inprocessed next, and the assignments made until the last time.
+    long next_inprocessing = 10000;
+    long inprocessed_assignments = 0;
+    // Variable failed literal probing continues from in the next round.
+    Var next_probe = 0;
+    InprocessingStats inprocessing_stats;
+    SearchStats stats;
+    // Cleared when clauses or assumptions may mention any variable later on, which then can't be substituted.
+    bool allow_elimination = true;
+    // Variables added after the input ones by symmetry breaking, which models leave out.
+    size_t auxiliary_variables_count = 0;
+
+    // Proof the derived and deleted clauses are logged to, if any. Clause ids, indexed by ClauseRef, and the ids of
+    // the unit clauses of the top-level assignments are only tracked for LRAT, which covers the search alone.
+    Proof *proof = nullptr;
+    std::vector<uint64_t> clause_ids;
+    std::vector<uint64_t> unit_ids;
+    // Number of top-level assignments on the trail that are logged as unit clauses.
+    size_t logged_units = 0;
+
+    // Set by another thread or a signal handler to stop the search, which then returns false.
+    const std::atomic<bool> *interrupt = nullptr;
+    SearchLimits limits;
+    // Set when the last search returned false because of the interrupt or a limit, without an answer. The best
+    // phases then hold the longest assignment it found without a conflict.
+    bool stopped = false;
+    bool verbose = true;
+
+    // Exchange the learned clauses are shared through when solving in a portfolio, and the index of this solver.
+    ClauseExchange *exchange = nullptr;
+    size_t exchange_worker = 0;
 
-    bool operator==(const SignedVariable &literal) const {
-        return sign == literal.sign && variable == literal.variable;
+    long new_iterations = 0;
+
+    Formula() = default;
+
+    size_t variables_count() const {
+        return values.size();
     }
-};
 
-struct hash_sv {
-    std::size_t operator()(const SignedVariable &literal) const {
-        std::size_t h1 = std::hash<Sign>()(literal.sign);
-        std::size_t h2 = std::hash<Variable *>()(literal.variable);
+    uint32_t decision_level() const {
+        return static_cast<uint32_t>(trail_limits.size());
+    }
 
-        return h1 ^ h2;
+    LiteralValue value(Literal literal) const {
+        LiteralValue variable_value = values[var_of(literal)];
+        if (variable_value == U) return U;
+        return (variable_value == T) != is_negative(literal) ? T : F;
     }
-};
 
-struct Clause {
-    std::list<SignedVariable> literals;
-    std::pair<SignedVariable, SignedVariable> watched;
-};
+    void set_variables_count(size_t);
 
-struct Variable {
-    ID id;
-    LiteralValue value;
+    void set_clauses_count(size_t);
 
-    Clause *implicated_by;
+    void add_clause(const std::vector<Literal> &);
 
-    std::list<Clause *> positive_occurrences;
-    std::list<Clause *> negative_occurrences;
+    ClauseRef add_learned_clause(const std::vector<Literal> &, uint32_t);
 
-    double positive_conflicts;
-    double negative_conflicts;
-};
+    void attach_clause(ClauseRef);
 
-struct Choice {
-    Choice() {
-        this->retry = false;
-        this->literal = SignedVariable();
-    }
+    void backtrack(uint32_t);
 
-    Choice(bool retry, SignedVariable literal) {
-        this->retry = retry;
-        this->literal = literal;
-    }
+    void decide(Literal);
 
+    // Assigns the literal at a new level like a decision, but without counting one, for probing and vivification.
+    void open_level(Literal);
 
-    bool retry{};
-    SignedVariable literal;
-};
+    void assign(Literal, ClauseRef);
 
-std::vector<std::string> split(const std::string &, char);
+    ClauseRef propagate();
 
-class Formula {
-public:
-    std::list<Clause *> clauses;
-    std::list<Variable *> variables;
-    std::list<Choice> choices;
+    bool solve(BranchingStrategy &, RestartStrategy &, const std::vector<Literal> &assumptions = {});
 
-    long new_conflicts = 0;
+    bool literal_redundant(Literal, uint32_t);
 
-    long current_ceiling = 1;
-    long absolute_ceiling = 2;
+    void analyze_final(Literal);
 
-    long new_iterations = 0;
+    uint32_t compute_lbd(const Literal *, const Literal *);
 
-    Formula() = default;
+    void bump_clause(Clause &);
 
-    ~Formula();
+    bool locked(ClauseRef) const;
 
-    void set_variables_count(size_t);
+    void reduce_learned_clauses();
 
-    void set_clauses_count(size_t);
+    void collect_garbage();
+
+    void extend_model();
 
-    void add_clause(const std::string &);
+    LiteralValue preferred_phase(Var) const;
 
-    void add_clause(const std::vector<long> &);
+    void update_target_phases(size_t);
 
-    void add_learned_clause(const std::unordered_set<SignedVariable, hash_sv> &);
+    void rephase();
 
-    bool backtrack();
+    bool limit_reached();
 
-    bool propagate(SignedVariable, Clause *, bool);
+    size_t memory_usage() const;
 
-    void depropagate(const SignedVariable &);
+    void print();
 
-    bool solve(const BranchingStrategy &);
+    void log_addition(const Literal *, const Literal *);
 
-    std::unordered_set<SignedVariable, hash_sv>
-    register_conflict(Variable *, Clause *, Clause *);
+    void log_deletion(const Literal *, const Literal *);
 
-    SignedVariable find_new_watched(Clause *);
+    void log_deletion(ClauseRef);
 
-    Choice find_conflicting_choice(Clause *);
+    void log_units();
+
+    void refute(ClauseRef);
+
+    bool import_shared_clauses();
+
+private:
+    // Buffers reused across added and imported clauses.
+    std::vector<Literal> clause_buffer;
+    std::vector<Literal> shared_buffer;
+
+    // Buffers reused across conflicts to avoid allocations during analysis.
+    std::vector<Literal> learned;
+    std::vector<Literal> analyze_stack;
+    std::vector<Literal> analyze_to_clear;
+    std::vector<uint64_t> level_stamps;
+    uint64_t lbd_stamp = 0;
+
+    // Search iterations since the clock and the memory were last checked against the limits.
+    long unchecked_iterations = 0;
+    // Inprocessing rounds whose totals were already printed with the progress.
+    long printed_rounds = 0;
+
+    // Clause ids an LRAT step follows from, and the variables marked while collecting them.
+    std::vector<uint64_t> hints;
+    std::vector<Var> hint_variables;
+
+    // Builds without proof support never log, so the checks compile away.
+    bool logging() const {
+        return PROOFS && proof != nullptr;
+    }
+
+    bool lrat() const {
+        return logging() && proof->lrat();
+    }
 
-    bool non_chronological_backtrack(const std::unordered_set<SignedVariable, hash_sv> &);
+    // The search loop and its hot paths are instantiated in Formula.cpp for the final strategy classes, whose calls
+    // are then direct, and for the strategy interfaces.
+    template<typename Branching, typename Restarts>
+    bool search(Branching &, Restarts &, const std::vector<Literal> &assumptions);
 
-    void print() const;
+    template<typename Branching>
+    const std::vector<Literal> &register_conflict(ClauseRef, uint32_t &, uint32_t &, Branching &);
 
-    void random_restart();
+    template<typename Branching>
+    void backtrack(uint32_t, Branching *);
 
-    void decay(double decay_factor);
+    template<typename Branching, typename Restarts>
+    void restart(Branching &, Restarts &);
 
-    bool check_clauses(const std::list<Clause *> &);
+    template<typename Branching, typename Restarts>
+    bool handle_conflict(ClauseRef, Branching &, Restarts &);
 
-    bool handle_conflict(Clause *);
+    void set_clause_id(ClauseRef, uint64_t);
 
-    bool check_all_satisfied();
+    void collect_hints(ClauseRef, const std::vector<Literal> &);
 };
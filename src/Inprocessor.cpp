@@ -0,0 +1,498 @@
+#include <algorithm>
+#include <cassert>
+
+#include "Inprocessor.h"
+
+#ifndef ASSERT
+#define ASSERT false
+#endif
+
+// Shares of the assignments made by the search since the previous round that probing and vivification may make,
+// and that subsumption may spend in literal visits.
+#define PROBE_EFFORT 0.05
+#define VIVIFY_EFFORT 0.1
+#define SUBSUMPTION_EFFORT 0.1
+// Longer clauses neither subsume nor get subsumed.
+#define SUBSUMPTION_SIZE_LIMIT 64
+
+bool Inprocessor::inprocess(long search_assignments) {
+    if (ASSERT) assert(formula.decision_level() == 0);
+    formula.inprocessing_stats.rounds++;
+    marks.assign(2 * formula.variables_count(), 0);
+
+    // Probing and vivification backtrack over their decisions, which must not overwrite the phases of the search.
+    std::vector<LiteralValue> saved_phases = formula.saved_phases;
+    bool consistent = formula.propagate() == CLAUSE_NONE &&
+                      probe(static_cast<long>(PROBE_EFFORT * static_cast<double>(search_assignments))) &&
+                      vivify(static_cast<long>(VIVIFY_EFFORT * static_cast<double>(search_assignments)));
+    formula.saved_phases = std::move(saved_phases);
+
+    consistent = consistent && (!formula.allow_elimination || substitute_equivalences()) &&
+                 subsume(static_cast<long>(SUBSUMPTION_EFFORT * static_cast<double>(search_assignments))) &&
+                 rebuild();
+    if (!consistent) formula.refute(CLAUSE_NONE);
+    return consistent;
+}
+
+// Assigns both polarities of the variables occurring in binary clauses, continuing where the previous round
+// stopped. A polarity that leads to a conflict is false.
+bool Inprocessor::probe(long budget) {
+    std::vector<uint8_t> in_binary(formula.variables_count(), 0);
+    for (Literal literal = 0; literal < formula.watches.size(); literal++) {
+        for (const Watcher &watcher: formula.watches[literal]) {
+            if (watcher.binary && !formula.arena[watcher.ref].deleted) in_binary[var_of(literal)] = 1;
+        }
+    }
+
+    Var variables_count = static_cast<Var>(formula.variables_count());
+    for (Var i = 0; i < variables_count && budget > 0; i++) {
+        Var variable = (formula.next_probe + i) % variables_count;
+        formula.next_probe = variable + 1;
+        if (!in_binary[variable] || formula.eliminated[variable]) continue;
+
+        for (const bool &negative: {false, true}) {
+            Literal literal = make_literal(variable, negative);
+            if (formula.value(literal) != U) break;
+
+            size_t start = formula.trail.size();
+            formula.open_level(literal);
+            bool failed = formula.propagate() != CLAUSE_NONE;
+            budget -= static_cast<long>(formula.trail.size() - start);
+            formula.backtrack(0);
+            if (!failed) continue;
+
+            formula.inprocessing_stats.failed_literals++;
+            Literal unit = negate(literal);
+            formula.log_addition(&unit, &unit + 1);
+            formula.assign(unit, CLAUSE_NONE);
+            if (formula.propagate() != CLAUSE_NONE) return false;
+        }
+    }
+    return true;
+}
+
+// Tries to shorten the learned clauses not tried before, the most useful ones first.
+bool Inprocessor::vivify(long budget) {
+    std::vector<ClauseRef> candidates;
+    for (const ClauseRef &ref: formula.learned_clauses) {
+        const Clause &clause = formula.arena[ref];
+        if (!clause.deleted && !clause.vivified && clause.size > 2) candidates.push_back(ref);
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [&](const ClauseRef &left, const ClauseRef &right) {
+        const Clause &left_clause = formula.arena[left];
+        const Clause &right_clause = formula.arena[right];
+        if (left_clause.lbd != right_clause.lbd) return left_clause.lbd < right_clause.lbd;
+        return left_clause.activity > right_clause.activity;
+    });
+
+    for (const ClauseRef &ref: candidates) {
+        if (budget <= 0) break;
+        if (!vivify_clause(ref, budget)) return false;
+    }
+    return true;
+}
+
+// Assigns the negations of the literals of the clause one by one. A conflict means the literals negated so far
+// already form a clause, a literal that becomes true can follow them directly, and a literal that becomes false
+// can be left out. The clause is replaced if that makes it shorter.
+bool Inprocessor::vivify_clause(ClauseRef ref, long &budget) {
+    Clause &clause = formula.arena[ref];
+    clause.vivified = true;
+    uint32_t size = clause.size;
+    uint32_t lbd = clause.lbd;
+    bool used = clause.used;
+    float activity = clause.activity;
+    literals.clear();
+    for (const Literal &literal: clause) {
+        LiteralValue literal_value = formula.value(literal);
+        // Satisfied clauses are deleted by rebuild().
+        if (literal_value == T) return true;
+        if (literal_value == U) literals.push_back(literal);
+    }
+
+    size_t kept = 0;
+    Literal implied = LITERAL_NONE;
+    for (size_t i = 0; i < literals.size(); i++) {
+        Literal literal = literals[i];
+        LiteralValue literal_value = formula.value(literal);
+        if (literal_value == T) {
+            implied = literal;
+            break;
+        }
+        if (literal_value == F) continue;
+
+        literals[kept++] = literal;
+        size_t start = formula.trail.size();
+        formula.open_level(negate(literal));
+        bool conflict = formula.propagate() != CLAUSE_NONE;
+        budget -= static_cast<long>(formula.trail.size() - start);
+        if (conflict) break;
+    }
+    formula.backtrack(0);
+    if (implied != LITERAL_NONE) literals[kept++] = implied;
+    literals.resize(kept);
+    if (literals.size() >= size) return true;
+
+    formula.inprocessing_stats.vivified_clauses++;
+    formula.inprocessing_stats.vivified_literals += size - literals.size();
+    if (literals.size() == 1) {
+        formula.log_addition(literals.data(), literals.data() + 1);
+        formula.log_deletion(ref);
+        formula.arena.free(ref);
+        formula.assign(literals[0], CLAUSE_NONE);
+        return formula.propagate() == CLAUSE_NONE;
+    }
+    // The shortened clause keeps the standing of the original one in reductions.
+    ClauseRef shortened = formula.add_learned_clause(literals, std::min(lbd, static_cast<uint32_t>(literals.size())));
+    Clause &shortened_clause = formula.arena[shortened];
+    shortened_clause.vivified = true;
+    shortened_clause.used = used;
+    shortened_clause.activity = activity;
+    formula.log_deletion(ref);
+    formula.arena.free(ref);
+    return true;
+}
+
+// Literals implying each other through binary clauses are equivalent. Every variable is replaced by the variable
+// of the smallest literal of its strongly connected component, and saved on the elimination stack as equal to it.
+bool Inprocessor::substitute_equivalences() {
+    size_t literals_count = 2 * formula.variables_count();
+
+    // Every binary clause (a b) gives the implications -a -> b and -b -> a, read off the binary watchers of a and b.
+    std::vector<uint32_t> edge_starts(literals_count + 1, 0);
+    std::vector<Literal> edges;
+    for (Literal literal = 0; literal < literals_count; literal++) {
+        if (formula.value(literal) == U) {
+            for (const Watcher &watcher: formula.watches[negate(literal)]) {
+                if (!watcher.binary || formula.arena[watcher.ref].deleted || formula.value(watcher.blocker) != U) {
+                    continue;
+                }
+                edges.push_back(watcher.blocker);
+            }
+        }
+        edge_starts[literal + 1] = static_cast<uint32_t>(edges.size());
+    }
+    if (edges.empty()) return true;
+
+    // Tarjan's algorithm without recursion. Components are completed in reverse topological order, so the
+    // complement of a component gets the negated representative if it was completed first.
+    const uint32_t unvisited = UINT32_MAX;
+    std::vector<uint32_t> indices(literals_count, unvisited);
+    std::vector<uint32_t> lowlinks(literals_count, 0);
+    std::vector<uint8_t> on_stack(literals_count, 0);
+    std::vector<Literal> representatives(literals_count, LITERAL_NONE);
+    std::vector<Literal> stack;
+    std::vector<Literal> component;
+    std::vector<std::pair<Literal, uint32_t>> calls;
+    uint32_t counter = 0;
+    for (Literal root = 0; root < literals_count; root++) {
+        if (indices[root] != unvisited || edge_starts[root] == edge_starts[root + 1]) continue;
+
+        indices[root] = lowlinks[root] = counter++;
+        stack.push_back(root);
+        on_stack[root] = 1;
+        calls.emplace_back(root, edge_starts[root]);
+        while (!calls.empty()) {
+            Literal node = calls.back().first;
+            if (calls.back().second < edge_starts[node + 1]) {
+                Literal successor = edges[calls.back().second++];
+                if (indices[successor] == unvisited) {
+                    indices[successor] = lowlinks[successor] = counter++;
+                    stack.push_back(successor);
+                    on_stack[successor] = 1;
+                    calls.emplace_back(successor, edge_starts[successor]);
+                } else if (on_stack[successor]) {
+                    lowlinks[node] = std::min(lowlinks[node], indices[successor]);
+                }
+                continue;
+            }
+
+            calls.pop_back();
+            if (!calls.empty()) {
+                Literal parent = calls.back().first;
+                lowlinks[parent] = std::min(lowlinks[parent], lowlinks[node]);
+            }
+            if (lowlinks[node] != indices[node]) continue;
+
+            component.clear();
+            Literal member;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                on_stack[member] = 0;
+                component.push_back(member);
+                marks[member] = 1;
+            } while (member != node);
+
+            // A literal equivalent to its own negation makes the formula unsatisfiable.
+            bool contradiction = false;
+            for (const Literal &literal: component) {
+                contradiction = contradiction || marks[negate(literal)];
+            }
+            for (const Literal &literal: component) {
+                marks[literal] = 0;
+            }
+            if (contradiction) return false;
+
+            Literal representative = *std::min_element(component.begin(), component.end());
+            if (representatives[negate(component[0])] != LITERAL_NONE) {
+                representative = negate(representatives[negate(component[0])]);
+            }
+            for (const Literal &literal: component) {
+                representatives[literal] = representative;
+            }
+        }
+    }
+
+    size_t substituted = 0;
+    for (Var variable = 0; variable < formula.variables_count(); variable++) {
+        Literal positive = make_literal(variable, false);
+        Literal representative = representatives[positive];
+        if (representative == LITERAL_NONE || var_of(representative) == variable) continue;
+
+        // The variable gets the value of its representative when the model is extended.
+        formula.elimination_stack.push_back(positive);
+        formula.elimination_stack.push_back(negate(representative));
+        formula.elimination_stack.push_back(2);
+        formula.elimination_stack.push_back(negate(positive));
+        formula.elimination_stack.push_back(representative);
+        formula.elimination_stack.push_back(2);
+        formula.eliminated[variable] = 1;
+        formula.eliminated_count++;
+        substituted++;
+    }
+    formula.inprocessing_stats.substituted_variables += static_cast<long>(substituted);
+    if (substituted == 0) return true;
+
+    // Rewrite the clauses in place, dropping duplicate literals and tautologies. The rewritten clauses follow from
+    // the binary clauses of the equivalences, so the original ones are only deleted from the proof at the end.
+    std::vector<Literal> original;
+    std::vector<Literal> deletions;
+    for (const auto *ref_list: {&formula.clauses, &formula.learned_clauses}) {
+        for (const ClauseRef &ref: *ref_list) {
+            Clause &clause = formula.arena[ref];
+            if (clause.deleted) continue;
+            bool touched = false;
+            for (const Literal &literal: clause) {
+                touched = touched || formula.eliminated[var_of(literal)];
+            }
+            if (!touched) continue;
+            if (formula.proof != nullptr) original.assign(clause.begin(), clause.end());
+
+            uint32_t size = 0;
+            bool tautology = false;
+            for (uint32_t i = 0; i < clause.size; i++) {
+                Literal literal = clause[i];
+                if (formula.eliminated[var_of(literal)]) literal = representatives[literal];
+                if (marks[literal]) continue;
+                tautology = tautology || marks[negate(literal)];
+                marks[literal] = 1;
+                clause[size++] = literal;
+            }
+            for (uint32_t i = 0; i < size; i++) {
+                marks[clause[i]] = 0;
+            }
+            if (tautology) {
+                formula.arena.free(ref);
+            } else {
+                clause.size = size;
+                formula.log_addition(clause.begin(), clause.end());
+            }
+            deletions.insert(deletions.end(), original.begin(), original.end());
+            deletions.push_back(static_cast<Literal>(original.size()));
+        }
+    }
+    // Stored like the elimination stack, each clause followed by its size.
+    size_t i = deletions.size();
+    while (i > 0) {
+        size_t size = deletions[--i];
+        i -= size;
+        formula.log_deletion(&deletions[i], &deletions[i] + size);
+    }
+    return true;
+}
+
+// Deletes the clauses subsumed by others and strengthens those that can be resolved with another clause into a
+// subset. Each clause is checked against the shorter ones, which are found through the occurrence list of just
+// one of their literals. A learned clause subsuming an original one takes its place as an original clause.
+bool Inprocessor::subsume(long budget) {
+    std::vector<ClauseRef> candidates;
+    for (const auto *ref_list: {&formula.clauses, &formula.learned_clauses}) {
+        for (const ClauseRef &ref: *ref_list) {
+            const Clause &clause = formula.arena[ref];
+            if (!clause.deleted && clause.size >= 2 && clause.size <= SUBSUMPTION_SIZE_LIMIT) {
+                candidates.push_back(ref);
+            }
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [&](const ClauseRef &left, const ClauseRef &right) {
+        return formula.arena[left].size < formula.arena[right].size;
+    });
+
+    std::vector<uint64_t> signatures(candidates.size(), 0);
+    std::vector<std::vector<uint32_t>> index(2 * formula.variables_count());
+    for (uint32_t i = 0; i < candidates.size() && budget > 0; i++) {
+        ClauseRef ref = candidates[i];
+        bool changed = true;
+        while (changed && !formula.arena[ref].deleted) {
+            changed = false;
+            Clause &clause = formula.arena[ref];
+            uint64_t signature = 0;
+            for (const Literal &literal: clause) {
+                signature |= 1ull << (var_of(literal) & 63);
+                marks[literal] = 1;
+            }
+
+            ClauseRef subsuming = CLAUSE_NONE;
+            Literal removed = LITERAL_NONE;
+            for (uint32_t k = 0; k < clause.size && subsuming == CLAUSE_NONE && removed == LITERAL_NONE; k++) {
+                for (const Literal &key: {clause[k], negate(clause[k])}) {
+                    for (const uint32_t &j: index[key]) {
+                        const Clause &other = formula.arena[candidates[j]];
+                        if (other.deleted || (signatures[j] & ~signature) != 0) continue;
+                        budget -= other.size;
+
+                        uint32_t matched = 0;
+                        Literal flipped = LITERAL_NONE;
+                        for (const Literal &literal: other) {
+                            if (marks[literal]) {
+                                matched++;
+                            } else if (marks[negate(literal)] && flipped == LITERAL_NONE) {
+                                flipped = literal;
+                                matched++;
+                            }
+                        }
+                        if (matched != other.size) continue;
+                        if (flipped == LITERAL_NONE) {
+                            subsuming = candidates[j];
+                        } else {
+                            removed = negate(flipped);
+                        }
+                        break;
+                    }
+                    if (subsuming != CLAUSE_NONE || removed != LITERAL_NONE) break;
+                }
+            }
+            for (const Literal &literal: clause) {
+                marks[literal] = 0;
+            }
+
+            if (subsuming != CLAUSE_NONE) {
+                if (!clause.learned) formula.arena[subsuming].learned = false;
+                formula.log_deletion(ref);
+                formula.arena.free(ref);
+                formula.inprocessing_stats.subsumed_clauses++;
+            } else if (removed != LITERAL_NONE) {
+                if (!strengthen(ref, removed)) return false;
+                changed = true;
+            }
+        }
+        if (formula.arena[ref].deleted) continue;
+
+        // Index the clause by its literal with the fewest indexed clauses so far.
+        const Clause &clause = formula.arena[ref];
+        Literal key = clause[0];
+        for (const Literal &literal: clause) {
+            signatures[i] |= 1ull << (var_of(literal) & 63);
+            if (index[literal].size() < index[key].size()) key = literal;
+        }
+        index[key].push_back(i);
+    }
+    return true;
+}
+
+// Removes the literal from the clause. Returns false if a resulting unit clause is already falsified.
+bool Inprocessor::strengthen(ClauseRef ref, Literal literal) {
+    Clause &clause = formula.arena[ref];
+    // The shortened clause is logged before the original one is deleted.
+    std::vector<Literal> original;
+    if (formula.proof != nullptr) original.assign(clause.begin(), clause.end());
+    Literal *position = std::find(clause.begin(), clause.end(), literal);
+    if (ASSERT) assert(position != clause.end());
+    *position = clause[clause.size - 1];
+    clause.size--;
+    formula.inprocessing_stats.strengthened_clauses++;
+    formula.log_addition(clause.begin(), clause.end());
+    formula.log_deletion(original.data(), original.data() + original.size());
+
+    if (clause.size > 1) return true;
+    // The unit clause stays in the proof, it is what the assignment follows from.
+    Literal unit = clause[0];
+    formula.arena.free(ref);
+    LiteralValue unit_value = formula.value(unit);
+    if (unit_value == U) formula.assign(unit, CLAUSE_NONE);
+    return unit_value != F;
+}
+
+// Brings the formula back into the state expected by the search: satisfied and deleted clauses removed, false
+// literals dropped, learned clauses that became original moved over, occurrences and watches rebuilt, and the
+// top-level assignments propagated without reasons.
+bool Inprocessor::rebuild() {
+    for (auto &watchers: formula.watches) {
+        watchers.clear();
+    }
+    // The clauses implying the top-level assignments are about to be deleted.
+    formula.log_units();
+
+    std::vector<ClauseRef> clauses;
+    std::vector<ClauseRef> learned_clauses;
+    std::vector<Literal> original;
+    for (const auto *ref_list: {&formula.clauses, &formula.learned_clauses}) {
+        for (const ClauseRef &ref: *ref_list) {
+            Clause &clause = formula.arena[ref];
+            if (clause.deleted) continue;
+            if (formula.proof != nullptr) original.assign(clause.begin(), clause.end());
+
+            bool satisfied = false;
+            uint32_t size = 0;
+            for (uint32_t i = 0; i < clause.size && !satisfied; i++) {
+                LiteralValue literal_value = formula.value(clause[i]);
+                satisfied = literal_value == T;
+                if (literal_value == U) clause[size++] = clause[i];
+            }
+            if (satisfied) {
+                formula.log_deletion(original.data(), original.data() + original.size());
+                formula.arena.free(ref);
+                continue;
+            }
+            if (size == 0) return false;
+            if (size < clause.size) {
+                formula.log_addition(clause.begin(), clause.begin() + size);
+                formula.log_deletion(original.data(), original.data() + original.size());
+            }
+            if (size == 1) {
+                formula.assign(clause[0], CLAUSE_NONE);
+                formula.arena.free(ref);
+                continue;
+            }
+            clause.size = size;
+            (clause.learned ? learned_clauses : clauses).push_back(ref);
+        }
+    }
+    formula.clauses = std::move(clauses);
+    formula.learned_clauses = std::move(learned_clauses);
+
+    for (auto &ref_list: formula.occurrences) {
+        ref_list.clear();
+    }
+    for (const ClauseRef &ref: formula.clauses) {
+        for (const Literal &literal: formula.arena[ref]) {
+            formula.occurrences[literal].push_back(ref);
+        }
+        formula.attach_clause(ref);
+    }
+    for (const ClauseRef &ref: formula.learned_clauses) {
+        formula.attach_clause(ref);
+    }
+
+    for (const Literal &literal: formula.trail) {
+        formula.implicated_by[var_of(literal)] = CLAUSE_NONE;
+    }
+    formula.propagation_head = 0;
+    if (formula.propagate() != CLAUSE_NONE) return false;
+
+    if (formula.arena.wasted() > formula.arena.size() / 5) {
+        formula.collect_garbage();
+    }
+    return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Formula.h"
+
+// Simplifies the clause database in between searches at the top level: failed literal probing, vivification of
+// the learned clauses, substitution of equivalent literals found as strongly connected components of the binary
+// implication graph, and subsumption among the learned and original clauses. Every technique gets a budget in
+// proportion to the assignments the search made since the previous round, and its results are counted in the
+// inprocessing stats of the formula.
+class Inprocessor {
+public:
+    explicit Inprocessor(Formula &formula) : formula(formula) {}
+
+    // Returns false if the formula turns out to be unsatisfiable, which also sets its empty clause flag.
+    bool inprocess(long search_assignments);
+
+private:
+    Formula &formula;
+
+    // Per-literal scratch marks, all clear in between operations.
+    std::vector<uint8_t> marks;
+    std::vector<Literal> literals;
+
+    bool probe(long budget);
+
+    bool vivify(long budget);
+
+    bool vivify_clause(ClauseRef, long &);
+
+    bool substitute_equivalences();
+
+    bool subsume(long budget);
+
+    bool strengthen(ClauseRef, Literal);
+
+    bool rebuild();
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+
+// Variables are dense indices starting from 0; DIMACS variable `v` maps to index `v - 1`.
+typedef uint32_t Var;
+
+// Literals are encoded as 2 * variable + (negative ? 1 : 0), so that both polarities of a variable
+// are adjacent and the negation is a single xor.
+typedef uint32_t Literal;
+
+const Var VAR_NONE = UINT32_MAX;
+const Literal LITERAL_NONE = UINT32_MAX;
+
+enum LiteralValue : uint8_t {
+    U, T, F
+};
+
+inline Literal make_literal(Var variable, bool negative) {
+    return (variable << 1) | static_cast<Literal>(negative);
+}
+
+inline Var var_of(Literal literal) {
+    return literal >> 1;
+}
+
+inline bool is_negative(Literal literal) {
+    return literal & 1;
+}
+
+inline Literal negate(Literal literal) {
+    return literal ^ 1;
+}
+
+inline Literal from_dimacs(long dimacs_literal) {
+    return make_literal(static_cast<Var>(std::labs(dimacs_literal) - 1), dimacs_literal < 0);
+}
+
+inline long to_dimacs(Literal literal) {
+    long id = static_cast<long>(var_of(literal)) + 1;
+    return is_negative(literal) ? -id : id;
+}
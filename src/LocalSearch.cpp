@@ -0,0 +1,186 @@
+#include <cassert>
+#include <cmath>
+
+#include "LocalSearch.h"
+
+#ifndef ASSERT
+#define ASSERT false
+#endif
+
+#define BREAK_LIMIT 64
+#define INTERRUPT_CHECK_FLIPS 4096
+
+LocalSearch::LocalSearch(const Formula &formula, unsigned seed) : variables_count(formula.variables_count()), mt(seed) {
+    if (ASSERT) assert(formula.decision_level() == 0);
+
+    fixed.assign(variables_count, U);
+    eliminated = formula.eliminated;
+    for (Var variable = 0; variable < variables_count; variable++) {
+        if (!eliminated[variable]) fixed[variable] = formula.values[variable];
+    }
+
+    // Only the literals still unassigned are kept, and satisfied clauses are skipped.
+    std::vector<uint32_t> occurrence_counts(2 * variables_count, 0);
+    size_t max_size = 0;
+    clause_starts.push_back(0);
+    for (const ClauseRef &ref: formula.clauses) {
+        const Clause &clause = formula.arena[ref];
+        if (clause.deleted) continue;
+        size_t start = clause_literals.size();
+        bool satisfied = false;
+        for (size_t i = 0; i < clause.size && !satisfied; i++) {
+            LiteralValue literal_value = formula.value(clause[i]);
+            satisfied = literal_value == T;
+            if (literal_value == U) clause_literals.push_back(clause[i]);
+        }
+        if (satisfied) {
+            clause_literals.resize(start);
+            continue;
+        }
+        if (clause_literals.size() == start) {
+            refuted = true;
+            continue;
+        }
+        for (size_t i = start; i < clause_literals.size(); i++) {
+            occurrence_counts[clause_literals[i]]++;
+        }
+        max_size = std::max(max_size, clause_literals.size() - start);
+        clause_starts.push_back(static_cast<uint32_t>(clause_literals.size()));
+    }
+
+    occurrence_starts.assign(2 * variables_count + 1, 0);
+    for (Literal literal = 0; literal < 2 * variables_count; literal++) {
+        occurrence_starts[literal + 1] = occurrence_starts[literal] + occurrence_counts[literal];
+    }
+    occurrence_clauses.resize(clause_literals.size());
+    for (uint32_t clause = 0; clause + 1 < clause_starts.size(); clause++) {
+        for (uint32_t i = clause_starts[clause]; i < clause_starts[clause + 1]; i++) {
+            Literal literal = clause_literals[i];
+            occurrence_clauses[occurrence_starts[literal + 1] - occurrence_counts[literal]--] = clause;
+        }
+    }
+
+    // The polynomial and exponential break functions and constants that work best for the clause length.
+    probabilities.resize(BREAK_LIMIT + 1);
+    for (size_t breaks = 0; breaks <= BREAK_LIMIT; breaks++) {
+        auto b = static_cast<double>(breaks);
+        if (max_size <= 3) {
+            probabilities[breaks] = std::pow(1 + b, -2.38);
+        } else {
+            double base = max_size == 4 ? 3.0 : max_size == 5 ? 3.7 : max_size == 6 ? 5.1 : 5.4;
+            probabilities[breaks] = std::pow(base, -b);
+        }
+    }
+}
+
+bool LocalSearch::walk(const std::vector<LiteralValue> &phases, long flips) {
+    initialize(phases);
+    if (refuted) return false;
+    size_t best_falsified = falsified.size();
+    save_best();
+
+    std::uniform_int_distribution<uint32_t> pick_clause;
+    std::uniform_real_distribution<double> pick_weight(0, 1);
+    for (long flip_count = 0; flip_count < flips && !falsified.empty(); flip_count++) {
+        if (flip_count % INTERRUPT_CHECK_FLIPS == 0 &&
+            ((interrupt != nullptr && interrupt->load(std::memory_order_relaxed)) ||
+             std::chrono::steady_clock::now() >= deadline)) {
+            return false;
+        }
+
+        uint32_t clause = falsified[pick_clause(mt) % falsified.size()];
+        uint32_t start = clause_starts[clause];
+        uint32_t end = clause_starts[clause + 1];
+
+        candidate_weights.clear();
+        double total = 0;
+        for (uint32_t i = start; i < end; i++) {
+            uint32_t breaks = std::min<uint32_t>(break_counts[var_of(clause_literals[i])], BREAK_LIMIT);
+            total += probabilities[breaks];
+            candidate_weights.push_back(total);
+        }
+        double threshold = pick_weight(mt) * total;
+        uint32_t chosen = start;
+        while (chosen + 1 < end && candidate_weights[chosen - start] <= threshold) {
+            chosen++;
+        }
+        flip(var_of(clause_literals[chosen]));
+
+        if (falsified.size() < best_falsified) {
+            best_falsified = falsified.size();
+            save_best();
+        }
+    }
+    return falsified.empty();
+}
+
+void LocalSearch::initialize(const std::vector<LiteralValue> &phases) {
+    assignment.assign(variables_count, 0);
+    for (Var variable = 0; variable < variables_count; variable++) {
+        LiteralValue phase = fixed[variable] != U ? fixed[variable] : phases[variable];
+        assignment[variable] = phase == U ? static_cast<uint8_t>(mt() & 1) : static_cast<uint8_t>(phase == T);
+    }
+
+    size_t clauses_count = clause_starts.size() - 1;
+    true_counts.assign(clauses_count, 0);
+    critical.assign(clauses_count, 0);
+    break_counts.assign(variables_count, 0);
+    falsified.clear();
+    falsified_positions.assign(clauses_count, 0);
+    for (uint32_t clause = 0; clause < clauses_count; clause++) {
+        for (uint32_t i = clause_starts[clause]; i < clause_starts[clause + 1]; i++) {
+            if (satisfies(clause_literals[i])) {
+                true_counts[clause]++;
+                critical[clause] ^= var_of(clause_literals[i]);
+            }
+        }
+        if (true_counts[clause] == 0) {
+            falsified_positions[clause] = static_cast<uint32_t>(falsified.size());
+            falsified.push_back(clause);
+        } else if (true_counts[clause] == 1) {
+            break_counts[critical[clause]]++;
+        }
+    }
+}
+
+void LocalSearch::flip(Var variable) {
+    assignment[variable] ^= 1;
+    Literal made_true = make_literal(variable, assignment[variable] == 0);
+    Literal made_false = negate(made_true);
+
+    for (uint32_t i = occurrence_starts[made_true]; i < occurrence_starts[made_true + 1]; i++) {
+        uint32_t clause = occurrence_clauses[i];
+        if (true_counts[clause] == 0) {
+            // Swap-remove from the falsified clauses.
+            uint32_t last = falsified.back();
+            falsified[falsified_positions[clause]] = last;
+            falsified_positions[last] = falsified_positions[clause];
+            falsified.pop_back();
+            break_counts[variable]++;
+        } else if (true_counts[clause] == 1) {
+            break_counts[critical[clause]]--;
+        }
+        true_counts[clause]++;
+        critical[clause] ^= variable;
+    }
+
+    for (uint32_t i = occurrence_starts[made_false]; i < occurrence_starts[made_false + 1]; i++) {
+        uint32_t clause = occurrence_clauses[i];
+        true_counts[clause]--;
+        critical[clause] ^= variable;
+        if (true_counts[clause] == 0) {
+            falsified_positions[clause] = static_cast<uint32_t>(falsified.size());
+            falsified.push_back(clause);
+            break_counts[variable]--;
+        } else if (true_counts[clause] == 1) {
+            break_counts[critical[clause]]++;
+        }
+    }
+}
+
+void LocalSearch::save_best() {
+    best.resize(variables_count);
+    for (Var variable = 0; variable < variables_count; variable++) {
+        best[variable] = eliminated[variable] ? U : assignment[variable] ? T : F;
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "Formula.h"
+
+// ProbSAT local search over a flat copy of the original clauses, simplified by the top-level assignment. A falsified
+// clause is picked at random and one of its variables flipped, preferring those whose flip falsifies the fewest
+// other clauses. These break counts are kept up to date incrementally, as is the list of falsified clauses.
+class LocalSearch {
+public:
+    // The formula has to be at the top level.
+    LocalSearch(const Formula &formula, unsigned seed);
+
+    // Flips from the given phases, random where unset, until every clause is satisfied, the flips run out or the
+    // search is interrupted. Returns true if a model was found.
+    bool walk(const std::vector<LiteralValue> &phases, long flips);
+
+    // Assignment with the fewest falsified clauses of the last walk, a model if it succeeded. Eliminated variables
+    // are left unassigned for Formula::extend_model().
+    const std::vector<LiteralValue> &best_phases() const {
+        return best;
+    }
+
+    // Checked every few thousand flips.
+    const std::atomic<bool> *interrupt = nullptr;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+private:
+    size_t variables_count;
+    // Set if a clause is falsified by the top-level assignment.
+    bool refuted = false;
+
+    std::vector<Literal> clause_literals;
+    // Clause i spans [clause_starts[i], clause_starts[i + 1]) of `clause_literals`.
+    std::vector<uint32_t> clause_starts;
+    // Clauses containing literal l are [occurrence_starts[l], occurrence_starts[l + 1]) of `occurrence_clauses`.
+    std::vector<uint32_t> occurrence_starts;
+    std::vector<uint32_t> occurrence_clauses;
+
+    // Variables fixed by the formula, kept out of the search, and those eliminated from it.
+    std::vector<LiteralValue> fixed;
+    std::vector<uint8_t> eliminated;
+    std::vector<uint8_t> assignment;
+
+    // Number of true literals of every clause, and the xor of their variables, which is the only one if there is one.
+    std::vector<uint32_t> true_counts;
+    std::vector<Var> critical;
+    // Number of clauses that only the variable satisfies.
+    std::vector<uint32_t> break_counts;
+
+    std::vector<uint32_t> falsified;
+    std::vector<uint32_t> falsified_positions;
+
+    // Relative probability of flipping a variable with the given break count.
+    std::vector<double> probabilities;
+    std::vector<double> candidate_weights;
+
+    std::vector<LiteralValue> best;
+    std::mt19937 mt;
+
+    bool satisfies(Literal literal) const {
+        return assignment[var_of(literal)] != is_negative(literal);
+    }
+
+    void initialize(const std::vector<LiteralValue> &phases);
+
+    void flip(Var variable);
+
+    void save_best();
+};
@@ -0,0 +1,130 @@
+#include <chrono>
+#include <climits>
+#include <mutex>
+#include <thread>
+
+#include "ClauseExchange.h"
+#include "LocalSearch.h"
+#include "Portfolio.h"
+
+// How often the workers are checked for having finished while the interrupt is watched, in milliseconds.
+#define INTERRUPT_POLL_INTERVAL 5
+
+bool Portfolio::solve(Formula &formula) const {
+    std::atomic<bool> finished(false);
+    std::atomic<size_t> running(threads);
+    std::mutex result_mutex;
+    bool sat = false;
+    bool answered = false;
+    std::vector<LiteralValue> model;
+    std::vector<LiteralValue> best_phases;
+    size_t best_size = 0;
+    SearchStats stats;
+    // Local search can't stop the others with a refutation, so it stops once every CDCL worker has.
+    size_t searching = 0;
+    for (size_t worker = 0; worker < threads; worker++) {
+        searching += !configuration(worker, restart_policy).local_search;
+    }
+    ClauseExchange exchange(threads);
+    // Each worker deletes clauses from its own copy only, which the others may still rely on.
+    if (formula.proof != nullptr) formula.proof->log_deletions = false;
+
+    auto work = [&](size_t worker) {
+        WorkerConfiguration config = configuration(worker, restart_policy);
+        Formula copy = make_worker_copy(formula, worker, config, finished, exchange);
+
+        bool result;
+        if (config.local_search) {
+            LocalSearch walker(copy, config.seed);
+            walker.interrupt = &finished;
+            walker.deadline = copy.limits.deadline;
+            result = !copy.empty_clause && walker.walk(copy.saved_phases, LONG_MAX);
+            // Interrupted, or refuted by preprocessing which the CDCL workers will report.
+            if (!result) return;
+            copy.values = walker.best_phases();
+            copy.extend_model();
+        } else {
+            VSIDSStrategy strategy(config.decay_factor, config.seed, config.initial_phase);
+            auto restarts = make_restart_strategy(config.restart_policy, config.luby_unit);
+            result = copy.solve(strategy, *restarts);
+        }
+
+        std::lock_guard<std::mutex> lock(result_mutex);
+        stats.add(copy.stats);
+        // A stopped worker has no answer, but its best assignment may be the best one.
+        if (copy.stopped) {
+            if (copy.best_size > best_size) {
+                best_phases = copy.best_phases;
+                best_size = copy.best_size;
+            }
+            if (--searching == 0) finished.store(true);
+            return;
+        }
+        if (finished.exchange(true)) return;
+        answered = true;
+        sat = result;
+        if (sat) {
+            model = std::move(copy.values);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_t worker = 0; worker < threads; worker++) {
+        workers.emplace_back([&, worker]() {
+            work(worker);
+            running--;
+        });
+    }
+    join(workers, running, finished, formula.interrupt);
+    formula.stats.add(stats);
+
+    if (sat) {
+        formula.values = std::move(model);
+    } else if (answered) {
+        formula.empty_clause = true;
+    } else {
+        formula.stopped = true;
+        formula.best_phases = std::move(best_phases);
+    }
+    return sat;
+}
+
+void Portfolio::join(std::vector<std::thread> &workers, const std::atomic<size_t> &running,
+                     std::atomic<bool> &finished, const std::atomic<bool> *interrupt) {
+    while (interrupt != nullptr && running.load() > 0) {
+        if (interrupt->load()) finished.store(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(INTERRUPT_POLL_INTERVAL));
+    }
+    for (auto &worker: workers) {
+        worker.join();
+    }
+}
+
+Formula Portfolio::make_worker_copy(const Formula &formula, size_t worker, const WorkerConfiguration &config,
+                                    std::atomic<bool> &finished, ClauseExchange &exchange) {
+    Formula copy(formula);
+    copy.random.seed(config.seed);
+    copy.stats = SearchStats();
+    copy.interrupt = &finished;
+    copy.exchange = &exchange;
+    copy.exchange_worker = worker;
+    // Only the first worker reports its progress.
+    copy.verbose = worker == 0;
+    return copy;
+}
+
+WorkerConfiguration Portfolio::configuration(size_t worker, RestartPolicy restart_policy) {
+    static const double decay_factors[] = {0.95, 0.85, 0.99, 0.9};
+    static const InitialPhase phases[] = {PHASE_OCCURRENCES, PHASE_NEGATIVE, PHASE_POSITIVE};
+
+    WorkerConfiguration config{};
+    config.seed = SEED + 7919 * static_cast<unsigned>(worker);
+    config.decay_factor = decay_factors[worker % 4];
+    config.initial_phase = phases[worker % 3];
+    // Every restart policy in turn, starting with the given one, and Luby units 1, 4, 16 or 64 times as long.
+    config.restart_policy = static_cast<RestartPolicy>((restart_policy + worker) % 3);
+    config.luby_unit = LUBY_UNIT << (2 * (worker / 3 % 4));
+    config.local_search = worker % 4 == 3;
+    return config;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Formula.h"
+#include "strategies/branching/VSIDSStrategy.h"
+#include "strategies/restart/RestartStrategy.h"
+
+// Search settings that tell the workers of a portfolio apart.
+struct WorkerConfiguration {
+    unsigned seed;
+    double decay_factor;
+    InitialPhase initial_phase;
+    RestartPolicy restart_policy;
+    long luby_unit;
+    // Runs local search instead of CDCL.
+    bool local_search;
+};
+
+// Runs copies of the solver with different configurations on their own threads, sharing short learned clauses
+// through a ClauseExchange. Every fourth worker runs local search instead, which can only ever find a model. The
+// first worker to finish decides the result and the others are interrupted. Workers that reach a limit of the
+// formula stop without deciding it; the formula is left stopped if they all do.
+class Portfolio {
+public:
+    Portfolio(size_t threads, RestartPolicy restart_policy) : threads(threads), restart_policy(restart_policy) {}
+
+    // Solves the formula and copies the model of the winning worker into it.
+    bool solve(Formula &formula) const;
+
+    // Joins the workers, setting `finished` for them when the interrupt of the formula is set. `running` counts the
+    // workers that haven't returned yet.
+    static void join(std::vector<std::thread> &workers, const std::atomic<size_t> &running,
+                     std::atomic<bool> &finished, const std::atomic<bool> *interrupt);
+
+    // Worker 0 uses the single-threaded configuration with the given restart policy.
+    static WorkerConfiguration configuration(size_t worker, RestartPolicy restart_policy);
+
+    // Copies the formula for a worker, stopped by `finished` and sharing clauses through the exchange. The copy
+    // starts without stats, so that only its own work is added back to the formula once the workers are joined;
+    // they copy the formula when they start, so it can't be added to before.
+    static Formula make_worker_copy(const Formula &formula, size_t worker, const WorkerConfiguration &config,
+                                    std::atomic<bool> &finished, ClauseExchange &exchange);
+
+private:
+    size_t threads;
+    RestartPolicy restart_policy;
+};
@@ -0,0 +1,481 @@
+#include <algorithm>
+#include <cassert>
+
+#include "Preprocessor.h"
+
+#ifndef ASSERT
+#define ASSERT false
+#endif
+
+// Number of assignments failed literal probing may make in total.
+#define PROBE_BUDGET 10000000
+// Number of literal visits subsumption and elimination may make in total.
+#define SIMPLIFY_BUDGET 200000000
+// Variables occurring more often than this in both polarities are not eliminated.
+#define ELIMINATION_OCCURRENCE_LIMIT 16
+// Eliminations producing a resolvent longer than this are not performed.
+#define RESOLVENT_SIZE_LIMIT 24
+
+bool Preprocessor::preprocess() {
+    if (formula.empty_clause) return false;
+    if (ASSERT) assert(formula.decision_level() == 0 && formula.learned_clauses.empty());
+
+    marks.assign(2 * formula.variables_count(), 0);
+
+    if (!propagate_units() || !probe()) {
+        formula.refute(CLAUSE_NONE);
+        return false;
+    }
+
+    // From here on the clauses are only reached through their occurrences.
+    remove_assigned();
+    build_occurrences();
+    if (!run_subsumption() || !eliminate_variables()) {
+        formula.refute(CLAUSE_NONE);
+        return false;
+    }
+
+    finish();
+    return true;
+}
+
+bool Preprocessor::propagate_units() {
+    for (const ClauseRef &ref: formula.clauses) {
+        const Clause &clause = formula.arena[ref];
+        if (clause.size != 1) continue;
+        if (formula.value(clause[0]) == F) return false;
+        if (formula.value(clause[0]) == U) formula.assign(clause[0], CLAUSE_NONE);
+    }
+    return formula.propagate() == CLAUSE_NONE;
+}
+
+// Assigns both polarities of every variable occurring in a binary clause at a temporary level. A polarity that
+// leads to a conflict is false, and the literals implied by both polarities are true.
+bool Preprocessor::probe() {
+    std::vector<uint8_t> in_binary(formula.variables_count(), 0);
+    for (const ClauseRef &ref: formula.clauses) {
+        const Clause &clause = formula.arena[ref];
+        if (clause.size != 2) continue;
+        in_binary[var_of(clause[0])] = 1;
+        in_binary[var_of(clause[1])] = 1;
+    }
+
+    std::vector<Literal> implied;
+    std::vector<Literal> lifted;
+    long budget = PROBE_BUDGET;
+    for (Var variable = 0; variable < formula.variables_count() && budget > 0; variable++) {
+        if (formula.values[variable] != U || !in_binary[variable]) continue;
+
+        bool failed;
+        if (!probe_literal(make_literal(variable, false), failed)) return false;
+        if (failed) continue;
+        size_t start = formula.trail_limits[0] + 1;
+        implied.assign(formula.trail.begin() + static_cast<long>(start), formula.trail.end());
+        budget -= static_cast<long>(formula.trail.size() - start + 1);
+        formula.backtrack(0);
+
+        for (const Literal &literal: implied) {
+            marks[literal] = 1;
+        }
+        lifted.clear();
+        bool consistent = probe_literal(make_literal(variable, true), failed);
+        if (consistent && !failed) {
+            for (size_t i = start; i < formula.trail.size(); i++) {
+                if (marks[formula.trail[i]]) lifted.push_back(formula.trail[i]);
+            }
+            budget -= static_cast<long>(formula.trail.size() - start + 1);
+            formula.backtrack(0);
+        }
+        for (const Literal &literal: implied) {
+            marks[literal] = 0;
+        }
+        if (!consistent) return false;
+
+        for (const Literal &literal: lifted) {
+            log_lifted(variable, literal);
+            if (formula.value(literal) == F) return false;
+            if (formula.value(literal) == U) formula.assign(literal, CLAUSE_NONE);
+        }
+        if (formula.propagate() != CLAUSE_NONE) return false;
+    }
+    return true;
+}
+
+// Leaves the implications of the literal on the trail at level 1 unless it fails, in which case its negation is
+// asserted at level 0. Returns false if that leads to a conflict.
+bool Preprocessor::probe_literal(Literal literal, bool &failed) {
+    formula.open_level(literal);
+    failed = formula.propagate() != CLAUSE_NONE;
+    if (!failed) return true;
+
+    formula.backtrack(0);
+    Literal unit = negate(literal);
+    formula.log_addition(&unit, &unit + 1);
+    formula.assign(unit, CLAUSE_NONE);
+    return formula.propagate() == CLAUSE_NONE;
+}
+
+// The literal is implied by both polarities of the variable, which the proof needs spelled out as binary clauses.
+void Preprocessor::log_lifted(Var variable, Literal literal) {
+    if (formula.proof == nullptr) return;
+    Literal positive[] = {make_literal(variable, true), literal};
+    Literal negative[] = {make_literal(variable, false), literal};
+    formula.log_addition(positive, positive + 2);
+    formula.log_addition(negative, negative + 2);
+    formula.log_addition(&literal, &literal + 1);
+    formula.log_deletion(positive, positive + 2);
+    formula.log_deletion(negative, negative + 2);
+}
+
+// Deletes the satisfied clauses and drops the false literals from the rest. The watches are discarded and only
+// rebuilt by finish().
+void Preprocessor::remove_assigned() {
+    for (auto &watchers: formula.watches) {
+        watchers.clear();
+    }
+    // The clauses implying the top-level assignments are about to be deleted.
+    formula.log_units();
+
+    // Clauses are rewritten in place, the proof needs them as they were.
+    std::vector<Literal> original;
+    size_t kept = 0;
+    for (const ClauseRef &ref: formula.clauses) {
+        Clause &clause = formula.arena[ref];
+        if (formula.proof != nullptr) original.assign(clause.begin(), clause.end());
+        bool satisfied = false;
+        uint32_t size = 0;
+        for (const Literal &literal: clause) {
+            LiteralValue literal_value = formula.value(literal);
+            if (literal_value == T) {
+                satisfied = true;
+                break;
+            }
+            if (literal_value == U) clause[size++] = literal;
+        }
+        if (satisfied) {
+            formula.log_deletion(original.data(), original.data() + original.size());
+            formula.arena.free(ref);
+            continue;
+        }
+        // Propagation leaves no unit or falsified clauses behind.
+        if (ASSERT) assert(size >= 2);
+        if (size < clause.size) {
+            formula.log_addition(clause.begin(), clause.begin() + size);
+            formula.log_deletion(original.data(), original.data() + original.size());
+        }
+        clause.size = size;
+        formula.clauses[kept++] = ref;
+    }
+    formula.clauses.resize(kept);
+    propagated = formula.trail.size();
+}
+
+void Preprocessor::build_occurrences() {
+    for (auto &ref_list: formula.occurrences) {
+        ref_list.clear();
+    }
+    for (const ClauseRef &ref: formula.clauses) {
+        for (const Literal &literal: formula.arena[ref]) {
+            formula.occurrences[literal].push_back(ref);
+        }
+        track_clause(ref);
+    }
+}
+
+// Computes the signature of the clause and queues it for subsumption.
+void Preprocessor::track_clause(ClauseRef ref) {
+    if (signatures.size() < formula.arena.size()) {
+        signatures.resize(formula.arena.size(), 0);
+        queued.resize(formula.arena.size(), 0);
+    }
+    uint64_t signature = 0;
+    for (const Literal &literal: formula.arena[ref]) {
+        signature |= 1ull << (var_of(literal) & 63);
+    }
+    signatures[ref] = signature;
+    enqueue(ref);
+}
+
+void Preprocessor::enqueue(ClauseRef ref) {
+    if (queued[ref]) return;
+    queued[ref] = 1;
+    subsumption_queue.push_back(ref);
+}
+
+// Assigns the literal at level 0 without propagating it. Returns false if it is already false.
+bool Preprocessor::enqueue_unit(Literal literal) {
+    LiteralValue literal_value = formula.value(literal);
+    if (literal_value == U) formula.assign(literal, CLAUSE_NONE);
+    return literal_value != F;
+}
+
+// Propagates the new top-level assignments by deleting the clauses they satisfy and removing the literals they
+// falsify.
+bool Preprocessor::propagate_occurrences() {
+    while (propagated < formula.trail.size()) {
+        Literal literal = formula.trail[propagated++];
+        for (const ClauseRef &ref: formula.occurrences[literal]) {
+            delete_clause(ref);
+        }
+        formula.occurrences[literal].clear();
+
+        std::vector<ClauseRef> falsified;
+        falsified.swap(formula.occurrences[negate(literal)]);
+        for (const ClauseRef &ref: falsified) {
+            if (!formula.arena[ref].deleted && !strengthen(ref, negate(literal))) return false;
+        }
+    }
+    return true;
+}
+
+// The clause stays in the occurrence lists of its literals until they are next traversed.
+void Preprocessor::delete_clause(ClauseRef ref) {
+    formula.log_deletion(ref);
+    formula.arena.free(ref);
+}
+
+// Removes the literal from the clause. Returns false if a resulting unit clause is already falsified.
+bool Preprocessor::strengthen(ClauseRef ref, Literal literal) {
+    Clause &clause = formula.arena[ref];
+    // The shortened clause is logged before the original one is deleted.
+    std::vector<Literal> original;
+    if (formula.proof != nullptr) original.assign(clause.begin(), clause.end());
+    Literal *position = std::find(clause.begin(), clause.end(), literal);
+    if (ASSERT) assert(position != clause.end());
+    *position = clause[clause.size - 1];
+    clause.size--;
+    formula.log_addition(clause.begin(), clause.end());
+    formula.log_deletion(original.data(), original.data() + original.size());
+
+    std::vector<ClauseRef> &ref_list = formula.occurrences[literal];
+    auto it = std::find(ref_list.begin(), ref_list.end(), ref);
+    if (it != ref_list.end()) {
+        *it = ref_list.back();
+        ref_list.pop_back();
+    }
+
+    if (clause.size == 1) {
+        // The unit clause stays in the proof, it is what the assignment follows from.
+        Literal unit = clause[0];
+        formula.arena.free(ref);
+        return enqueue_unit(unit);
+    }
+    track_clause(ref);
+    return true;
+}
+
+// Deletes the clauses the given one subsumes and strengthens those it can be resolved with into a subset.
+bool Preprocessor::subsume(ClauseRef ref) {
+    const Clause &clause = formula.arena[ref];
+
+    // Every candidate contains the variable with the fewest occurrences.
+    Literal pivot = clause[0];
+    for (const Literal &literal: clause) {
+        if (formula.occurrences[literal].size() + formula.occurrences[negate(literal)].size() <
+            formula.occurrences[pivot].size() + formula.occurrences[negate(pivot)].size()) {
+            pivot = literal;
+        }
+    }
+    std::vector<ClauseRef> candidates(formula.occurrences[pivot]);
+    candidates.insert(candidates.end(), formula.occurrences[negate(pivot)].begin(),
+                      formula.occurrences[negate(pivot)].end());
+
+    for (const Literal &literal: clause) {
+        marks[literal] = 1;
+    }
+    bool consistent = true;
+    for (const ClauseRef &other_ref: candidates) {
+        if (other_ref == ref) continue;
+        const Clause &other = formula.arena[other_ref];
+        if (other.deleted || other.size < clause.size || (signatures[ref] & ~signatures[other_ref]) != 0) continue;
+
+        steps += other.size;
+        uint32_t matched = 0;
+        Literal flipped = LITERAL_NONE;
+        for (const Literal &literal: other) {
+            if (marks[literal]) {
+                matched++;
+            } else if (marks[negate(literal)] && flipped == LITERAL_NONE) {
+                flipped = literal;
+                matched++;
+            }
+        }
+        if (matched != clause.size) continue;
+
+        if (flipped == LITERAL_NONE) {
+            delete_clause(other_ref);
+        } else if (!strengthen(other_ref, flipped)) {
+            consistent = false;
+            break;
+        }
+    }
+    for (const Literal &literal: clause) {
+        marks[literal] = 0;
+    }
+    return consistent && propagate_occurrences();
+}
+
+bool Preprocessor::run_subsumption() {
+    // Shorter clauses subsume more, so they go first.
+    std::sort(subsumption_queue.begin(), subsumption_queue.end(), [&](const ClauseRef &left, const ClauseRef &right) {
+        return formula.arena[left].size > formula.arena[right].size;
+    });
+    while (!subsumption_queue.empty()) {
+        ClauseRef ref = subsumption_queue.back();
+        subsumption_queue.pop_back();
+        queued[ref] = 0;
+        if (formula.arena[ref].deleted || steps > SIMPLIFY_BUDGET) continue;
+        if (!subsume(ref)) return false;
+    }
+    return true;
+}
+
+// Drops the deleted clauses from the occurrence list of the literal.
+std::vector<ClauseRef> &Preprocessor::live_occurrences(Literal literal) {
+    std::vector<ClauseRef> &ref_list = formula.occurrences[literal];
+    ref_list.erase(std::remove_if(ref_list.begin(), ref_list.end(), [&](const ClauseRef &ref) {
+        return formula.arena[ref].deleted;
+    }), ref_list.end());
+    return ref_list;
+}
+
+// Resolves the clauses on the variable. Returns false if the resolvent is a tautology.
+bool Preprocessor::resolve(const Clause &positive, const Clause &negative, Var variable,
+                           std::vector<Literal> &resolvent) {
+    resolvent.clear();
+    for (const Literal &literal: positive) {
+        if (var_of(literal) == variable) continue;
+        marks[literal] = 1;
+        resolvent.push_back(literal);
+    }
+    bool tautology = false;
+    for (const Literal &literal: negative) {
+        if (var_of(literal) == variable || marks[literal]) continue;
+        if (marks[negate(literal)]) {
+            tautology = true;
+            break;
+        }
+        resolvent.push_back(literal);
+    }
+    for (const Literal &literal: positive) {
+        marks[literal] = 0;
+    }
+    steps += positive.size + negative.size;
+    return !tautology;
+}
+
+bool Preprocessor::eliminate_variables() {
+    // Cheap variables first, their resolvents are the least likely to block later eliminations.
+    std::vector<Var> order;
+    std::vector<size_t> cost(formula.variables_count());
+    for (Var variable = 0; variable < formula.variables_count(); variable++) {
+        if (formula.values[variable] != U) continue;
+        cost[variable] = formula.occurrences[make_literal(variable, false)].size() *
+                         formula.occurrences[make_literal(variable, true)].size();
+        order.push_back(variable);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](const Var &left, const Var &right) {
+        return cost[left] < cost[right];
+    });
+
+    for (const Var &variable: order) {
+        if (steps > SIMPLIFY_BUDGET) break;
+        if (formula.values[variable] != U) continue;
+        if (!eliminate(variable) || !run_subsumption()) return false;
+    }
+    return true;
+}
+
+// Replaces the clauses of the variable with all their non-tautological resolvents, unless there are more of
+// them than the clauses they replace.
+bool Preprocessor::eliminate(Var variable) {
+    Literal positive = make_literal(variable, false);
+    Literal negative = make_literal(variable, true);
+    std::vector<ClauseRef> &positive_refs = live_occurrences(positive);
+    std::vector<ClauseRef> &negative_refs = live_occurrences(negative);
+    if (positive_refs.size() > ELIMINATION_OCCURRENCE_LIMIT && negative_refs.size() > ELIMINATION_OCCURRENCE_LIMIT) {
+        return true;
+    }
+
+    std::vector<std::vector<Literal>> resolvents;
+    std::vector<Literal> resolvent;
+    size_t limit = positive_refs.size() + negative_refs.size();
+    for (const ClauseRef &positive_ref: positive_refs) {
+        for (const ClauseRef &negative_ref: negative_refs) {
+            if (!resolve(formula.arena[positive_ref], formula.arena[negative_ref], variable, resolvent)) continue;
+            if (resolvent.size() > RESOLVENT_SIZE_LIMIT || resolvents.size() == limit) return true;
+            resolvents.push_back(resolvent);
+        }
+    }
+
+    // Save the clauses of the rarer polarity, followed by the other polarity as a default.
+    bool save_positive = positive_refs.size() <= negative_refs.size();
+    for (const ClauseRef &ref: save_positive ? positive_refs : negative_refs) {
+        const Clause &clause = formula.arena[ref];
+        formula.elimination_stack.push_back(save_positive ? positive : negative);
+        for (const Literal &literal: clause) {
+            if (var_of(literal) != variable) formula.elimination_stack.push_back(literal);
+        }
+        formula.elimination_stack.push_back(clause.size);
+    }
+    formula.elimination_stack.push_back(save_positive ? negative : positive);
+    formula.elimination_stack.push_back(1);
+
+    // The resolvents go into the proof before the clauses they are derived from are deleted.
+    for (const auto &literals: resolvents) {
+        if (!add_resolvent(literals)) return false;
+    }
+    for (const ClauseRef &ref: positive_refs) {
+        delete_clause(ref);
+    }
+    for (const ClauseRef &ref: negative_refs) {
+        delete_clause(ref);
+    }
+    positive_refs.clear();
+    negative_refs.clear();
+    formula.eliminated[variable] = 1;
+    formula.eliminated_count++;
+    return propagate_occurrences();
+}
+
+bool Preprocessor::add_resolvent(const std::vector<Literal> &literals) {
+    std::vector<Literal> clause_literals;
+    for (const Literal &literal: literals) {
+        LiteralValue literal_value = formula.value(literal);
+        if (literal_value == T) return true;
+        if (literal_value == U) clause_literals.push_back(literal);
+    }
+    if (clause_literals.empty()) return false;
+    formula.log_addition(clause_literals.data(), clause_literals.data() + clause_literals.size());
+    if (clause_literals.size() == 1) return enqueue_unit(clause_literals[0]);
+
+    ClauseRef ref = formula.arena.allocate(clause_literals, false);
+    formula.clauses.push_back(ref);
+    for (const Literal &literal: clause_literals) {
+        formula.occurrences[literal].push_back(ref);
+    }
+    track_clause(ref);
+    return true;
+}
+
+// Brings the formula back into the state expected by the search: live clauses only, watches attached, and the
+// top-level assignments without reasons or saved phases from probing.
+void Preprocessor::finish() {
+    formula.clauses.erase(std::remove_if(formula.clauses.begin(), formula.clauses.end(), [&](const ClauseRef &ref) {
+        return formula.arena[ref].deleted;
+    }), formula.clauses.end());
+    for (Literal literal = 0; literal < formula.occurrences.size(); literal++) {
+        live_occurrences(literal);
+    }
+    for (const ClauseRef &ref: formula.clauses) {
+        formula.attach_clause(ref);
+    }
+
+    for (const Literal &literal: formula.trail) {
+        formula.implicated_by[var_of(literal)] = CLAUSE_NONE;
+    }
+    formula.propagation_head = formula.trail.size();
+    std::fill(formula.saved_phases.begin(), formula.saved_phases.end(), U);
+
+    formula.collect_garbage();
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Formula.h"
+
+// Simplifies the original clauses of a formula before the search starts: top-level unit propagation, failed
+// literal probing, backward subsumption, self-subsuming resolution and bounded variable elimination. Clauses of
+// eliminated variables are saved on the elimination stack of the formula so that the model can be extended.
+class Preprocessor {
+public:
+    explicit Preprocessor(Formula &formula) : formula(formula) {}
+
+    // Returns false if the formula turns out to be unsatisfiable, which also sets its empty clause flag.
+    bool preprocess();
+
+private:
+    Formula &formula;
+
+    // Variable signature and subsumption queue membership of every clause, indexed by ClauseRef.
+    std::vector<uint64_t> signatures;
+    std::vector<uint8_t> queued;
+    std::vector<ClauseRef> subsumption_queue;
+
+    // Per-literal scratch marks, all clear in between operations.
+    std::vector<uint8_t> marks;
+
+    // Position in the trail up to which assignments were propagated through the occurrence lists.
+    size_t propagated = 0;
+
+    long steps = 0;
+
+    bool propagate_units();
+
+    bool probe();
+
+    bool probe_literal(Literal, bool &);
+
+    void log_lifted(Var, Literal);
+
+    void remove_assigned();
+
+    void build_occurrences();
+
+    void track_clause(ClauseRef);
+
+    void enqueue(ClauseRef);
+
+    bool enqueue_unit(Literal);
+
+    bool propagate_occurrences();
+
+    void delete_clause(ClauseRef);
+
+    bool strengthen(ClauseRef, Literal);
+
+    bool subsume(ClauseRef);
+
+    bool run_subsumption();
+
+    std::vector<ClauseRef> &live_occurrences(Literal);
+
+    bool resolve(const Clause &, const Clause &, Var, std::vector<Literal> &);
+
+    bool eliminate_variables();
+
+    bool eliminate(Var);
+
+    bool add_resolvent(const std::vector<Literal> &);
+
+    void finish();
+};
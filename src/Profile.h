@@ -0,0 +1,22 @@
+#pragma once
+
+#include <chrono>
+
+// Adds the time spent in its scope to a running total, in seconds. Only builds with PROFILE defined measure anything,
+// elsewhere the timer is empty and compiles away.
+class ProfileTimer {
+public:
+#ifdef PROFILE
+    explicit ProfileTimer(double &total) : total(total), start(std::chrono::steady_clock::now()) {}
+
+    ~ProfileTimer() {
+        total += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    double &total;
+    std::chrono::steady_clock::time_point start;
+#else
+    explicit ProfileTimer(double &) {}
+#endif
+};
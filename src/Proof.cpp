@@ -0,0 +1,154 @@
+#include <cerrno>
+#include <cstring>
+
+#include "Proof.h"
+
+// Size at which the buffer is handed to the writer thread.
+#define PROOF_BUFFER_SIZE (4 << 20)
+
+Proof::Proof(const std::string &path, ProofFormat format) : format(format) {
+    file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        throw ProofError("cannot create " + path + ": " + std::strerror(errno));
+    }
+    buffer.reserve(PROOF_BUFFER_SIZE + 4096);
+    pending.reserve(PROOF_BUFFER_SIZE + 4096);
+    writer = std::thread(&Proof::write_pending, this);
+}
+
+Proof::~Proof() {
+    close();
+}
+
+uint64_t Proof::input_clause() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return ++last_id;
+}
+
+uint64_t Proof::add(const Literal *begin, const Literal *end, const std::vector<uint64_t> &hints) {
+    std::unique_lock<std::mutex> lock(mutex);
+    uint64_t id = ++last_id;
+    bool binary = format == PROOF_DRAT || format == PROOF_LRAT;
+    if (binary) buffer.push_back('a');
+    if (lrat()) write_hint(id);
+    for (const Literal *literal = begin; literal != end; literal++) {
+        write_literal(*literal);
+    }
+    write_number(0);
+    if (lrat()) {
+        for (const uint64_t &hint: hints) {
+            write_hint(hint);
+        }
+        write_number(0);
+    }
+    if (!binary) buffer.back() = '\n';
+    hand_off(lock);
+    return id;
+}
+
+void Proof::remove(const Literal *begin, const Literal *end, uint64_t id) {
+    if (!log_deletions) return;
+    std::unique_lock<std::mutex> lock(mutex);
+    switch (format) {
+        case PROOF_DRAT:
+        case PROOF_DRAT_TEXT:
+            buffer.push_back('d');
+            if (format == PROOF_DRAT_TEXT) buffer.push_back(' ');
+            for (const Literal *literal = begin; literal != end; literal++) {
+                write_literal(*literal);
+            }
+            write_number(0);
+            break;
+        case PROOF_LRAT:
+            buffer.push_back('d');
+            write_hint(id);
+            write_number(0);
+            break;
+        case PROOF_LRAT_TEXT:
+            // A text deletion is numbered like the last addition.
+            write_number(last_id);
+            buffer.push_back('d');
+            buffer.push_back(' ');
+            write_hint(id);
+            write_number(0);
+            break;
+    }
+    if (format == PROOF_DRAT_TEXT || format == PROOF_LRAT_TEXT) buffer.back() = '\n';
+    hand_off(lock);
+}
+
+void Proof::close() {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (closing) return;
+        written.wait(lock, [&]() { return pending.empty(); });
+        pending.swap(buffer);
+        closing = true;
+    }
+    ready.notify_one();
+    writer.join();
+    std::fclose(file);
+}
+
+// Binary numbers are written 7 bits at a time from the lowest ones, the high bit of a byte telling that more
+// follow. Text numbers are followed by a space.
+void Proof::write_number(uint64_t number) {
+    if (format == PROOF_DRAT || format == PROOF_LRAT) {
+        while (number > 127) {
+            buffer.push_back(static_cast<char>(0x80 | (number & 0x7f)));
+            number >>= 7;
+        }
+        buffer.push_back(static_cast<char>(number));
+        return;
+    }
+    char digits[20];
+    size_t count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + number % 10);
+        number /= 10;
+    } while (number > 0);
+    while (count > 0) {
+        buffer.push_back(digits[--count]);
+    }
+    buffer.push_back(' ');
+}
+
+// The binary formats map DIMACS literal l to 2|l| + (l < 0), which is exactly 2 more than our encoding.
+void Proof::write_literal(Literal literal) {
+    if (format == PROOF_DRAT || format == PROOF_LRAT) {
+        write_number(static_cast<uint64_t>(literal) + 2);
+        return;
+    }
+    if (is_negative(literal)) buffer.push_back('-');
+    write_number(static_cast<uint64_t>(var_of(literal)) + 1);
+}
+
+// Clause ids are written like positive literals, as twice their value in the binary format.
+void Proof::write_hint(uint64_t id) {
+    write_number(format == PROOF_LRAT ? 2 * id : id);
+}
+
+// Passes a full buffer on to the writer thread, waiting for it to finish the previous one first.
+void Proof::hand_off(std::unique_lock<std::mutex> &lock) {
+    if (buffer.size() < PROOF_BUFFER_SIZE) return;
+    written.wait(lock, [&]() { return pending.empty(); });
+    pending.swap(buffer);
+    lock.unlock();
+    ready.notify_one();
+}
+
+void Proof::write_pending() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        ready.wait(lock, [&]() { return !pending.empty() || closing; });
+        if (!pending.empty()) {
+            lock.unlock();
+            std::fwrite(pending.data(), 1, pending.size(), file);
+            lock.lock();
+            pending.clear();
+            written.notify_all();
+        }
+        if (closing && pending.empty()) break;
+    }
+    std::fflush(file);
+}
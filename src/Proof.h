@@ -0,0 +1,89 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Literal.h"
+
+// Proof support can be left out of a build, which then never logs.
+#ifndef PROOFS
+#define PROOFS true
+#endif
+
+enum ProofFormat {
+    PROOF_DRAT, PROOF_DRAT_TEXT, PROOF_LRAT, PROOF_LRAT_TEXT
+};
+
+class ProofError : public std::runtime_error {
+public:
+    explicit ProofError(const std::string &message) : std::runtime_error(message) {}
+};
+
+// Streams the clauses derived and deleted by the solver to a DRAT or LRAT proof, in the binary or the text format.
+// Steps are encoded into a buffer that a background thread writes out once it is full, so that the search only
+// waits for the disk when it produces steps faster than they can be written. Steps may be logged from several
+// threads at once.
+//
+// LRAT steps carry the ids of the clauses they follow from; the input clauses are numbered from 1 in the order
+// they are read, so the proof has to be opened before the formula is parsed.
+class Proof {
+public:
+    // Throws ProofError if the file can't be created.
+    Proof(const std::string &path, ProofFormat format);
+
+    ~Proof();
+
+    Proof(const Proof &) = delete;
+
+    Proof &operator=(const Proof &) = delete;
+
+    bool lrat() const {
+        return format == PROOF_LRAT || format == PROOF_LRAT_TEXT;
+    }
+
+    // Assigns the id of the next input clause.
+    uint64_t input_clause();
+
+    // Logs a derived clause and returns its id. The hints are only written to LRAT proofs.
+    uint64_t add(const Literal *begin, const Literal *end, const std::vector<uint64_t> &hints = {});
+
+    // Logs the deletion of a clause, which is identified by its literals in DRAT and by its id in LRAT.
+    void remove(const Literal *begin, const Literal *end, uint64_t id);
+
+    // Writes out everything logged so far and closes the file; nothing can be logged afterwards.
+    void close();
+
+    // Cleared when solvers sharing the proof keep their own copies of the clauses, which one of them can't delete
+    // for all of them.
+    bool log_deletions = true;
+
+private:
+    ProofFormat format;
+    std::FILE *file;
+    uint64_t last_id = 0;
+
+    // Steps are encoded into `buffer`, and full buffers are handed to the writer thread as `pending`.
+    std::vector<char> buffer;
+    std::vector<char> pending;
+    bool closing = false;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable written;
+    std::thread writer;
+
+    void write_number(uint64_t);
+
+    void write_literal(Literal);
+
+    void write_hint(uint64_t);
+
+    void hand_off(std::unique_lock<std::mutex> &);
+
+    void write_pending();
+};
@@ -0,0 +1,456 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+#include "ProofChecker.h"
+
+#define CLAUSE_NONE UINT32_MAX
+
+// States of a clause. Lemmas are retired once the backward pass is past them, they never come back.
+#define CLAUSE_INACTIVE 0
+#define CLAUSE_ACTIVE 1
+#define CLAUSE_RETIRED 2
+
+namespace {
+
+    // Numbers of a proof in the binary or the text format. Binary numbers map n to 2|n| + (n < 0) in 7-bit groups,
+    // the lowest first.
+    class ProofReader {
+    public:
+        ProofReader(const std::vector<char> &data, bool binary) : data(data), binary(binary) {}
+
+        // Skips whitespace and comment lines of the text format. Returns false at the end of the proof.
+        bool next_step() {
+            if (binary) return position < data.size();
+            while (position < data.size()) {
+                char c = data[position];
+                if (c == 'c') {
+                    while (position < data.size() && data[position] != '\n') position++;
+                } else if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+                    position++;
+                } else {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Consumes the marker of a deletion step, or of an addition in the binary format.
+        bool deletion() {
+            if (binary) {
+                char kind = position < data.size() ? data[position++] : '\0';
+                if (kind != 'a' && kind != 'd') fail("expected 'a' or 'd'");
+                return kind == 'd';
+            }
+            skip_spaces();
+            if (position < data.size() && data[position] == 'd') {
+                position++;
+                return true;
+            }
+            return false;
+        }
+
+        int64_t read_number() {
+            if (binary) {
+                uint64_t encoded = 0;
+                for (unsigned shift = 0;; shift += 7) {
+                    if (position == data.size() || shift > 63) fail("truncated number");
+                    auto byte = static_cast<unsigned char>(data[position++]);
+                    encoded |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                    if ((byte & 0x80) == 0) break;
+                }
+                auto magnitude = static_cast<int64_t>(encoded >> 1);
+                return encoded & 1 ? -magnitude : magnitude;
+            }
+
+            skip_spaces();
+            bool negative = position < data.size() && data[position] == '-';
+            if (negative) position++;
+            if (position == data.size() || data[position] < '0' || data[position] > '9') fail("expected a number");
+            int64_t number = 0;
+            while (position < data.size() && data[position] >= '0' && data[position] <= '9') {
+                if (number > (INT64_MAX - 9) / 10) fail("number out of range");
+                number = 10 * number + (data[position++] - '0');
+            }
+            return negative ? -number : number;
+        }
+
+        // Reads literals up to the terminating zero.
+        void read_literals(std::vector<Literal> &literals) {
+            literals.clear();
+            int64_t number;
+            while ((number = read_number()) != 0) {
+                int64_t limit = static_cast<int64_t>(LITERAL_NONE / 2);
+                if (number > limit || -number > limit) fail("literal out of range");
+                literals.push_back(from_dimacs(static_cast<long>(number)));
+            }
+        }
+
+        [[noreturn]] void fail(const std::string &message) const {
+            throw ProofError("proof byte " + std::to_string(position) + ": " + message);
+        }
+
+    private:
+        const std::vector<char> &data;
+        bool binary;
+        size_t position = 0;
+
+        void skip_spaces() {
+            while (position < data.size() && (data[position] == ' ' || data[position] == '\t' ||
+                                              data[position] == '\n' || data[position] == '\r')) {
+                position++;
+            }
+        }
+    };
+
+    // Hash of a clause that doesn't depend on the order of its literals.
+    uint64_t clause_hash(const Literal *begin, const Literal *end) {
+        uint64_t hash = 0;
+        for (const Literal *literal = begin; literal != end; literal++) {
+            uint64_t mixed = (*literal + 1) * 0x9e3779b97f4a7c15ull;
+            hash += mixed ^ (mixed >> 29);
+        }
+        return hash;
+    }
+}
+
+ProofChecker::ProofChecker(const Cnf &cnf) {
+    starts.push_back(0);
+    ensure_variables(cnf.variables_count());
+    size_t begin = 0;
+    for (const size_t &end: cnf.clause_ends) {
+        buffer.assign(cnf.literals.begin() + static_cast<long>(begin), cnf.literals.begin() + static_cast<long>(end));
+        empty_input = empty_input || buffer.empty();
+        activate(store(buffer));
+        begin = end;
+    }
+    input_count = cnf.clause_ends.size();
+}
+
+bool ProofChecker::check(const std::string &path, ProofFormat format) {
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        throw ProofError("cannot open " + path + ": " + std::strerror(errno));
+    }
+    std::vector<char> data;
+    char chunk[1 << 16];
+    size_t count;
+    while ((count = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + count);
+    }
+    std::fclose(file);
+
+    failure.clear();
+    lemmas_count = checked_count = 0;
+    // An empty input clause needs no proof.
+    if (empty_input) return true;
+
+    bool binary = format == PROOF_DRAT || format == PROOF_LRAT;
+    if (format == PROOF_LRAT || format == PROOF_LRAT_TEXT) return check_lrat(data, binary);
+    return check_drat(data, binary);
+}
+
+// Adds the clause to the database, inactive and without watches.
+uint32_t ProofChecker::store(std::vector<Literal> &clause) {
+    std::sort(clause.begin(), clause.end());
+    clause.erase(std::unique(clause.begin(), clause.end()), clause.end());
+    for (const Literal &literal: clause) {
+        ensure_variables(var_of(literal) + 1);
+    }
+    literals.insert(literals.end(), clause.begin(), clause.end());
+    starts.push_back(literals.size());
+    active.push_back(0);
+    core.push_back(0);
+    return static_cast<uint32_t>(starts.size() - 2);
+}
+
+// Inactive clauses stay in the watch lists and are skipped when they are visited, retired ones are dropped.
+void ProofChecker::activate(uint32_t clause) {
+    active[clause] = CLAUSE_ACTIVE;
+    if (size(clause) == 1) {
+        units.push_back(clause);
+    } else if (size(clause) >= 2) {
+        watches[literals[starts[clause]]].push_back(clause);
+        watches[literals[starts[clause] + 1]].push_back(clause);
+    }
+}
+
+void ProofChecker::ensure_variables(size_t count) {
+    if (reasons.size() >= count) return;
+    values.resize(2 * count, U);
+    watches.resize(2 * count);
+    reasons.resize(count, CLAUSE_NONE);
+    seen.resize(count, 0);
+}
+
+void ProofChecker::assign(Literal literal, uint32_t reason) {
+    values[literal] = T;
+    values[negate(literal)] = F;
+    reasons[var_of(literal)] = reason;
+    trail.push_back(literal);
+}
+
+void ProofChecker::reset() {
+    for (const Literal &literal: trail) {
+        values[literal] = U;
+        values[negate(literal)] = U;
+    }
+    trail.clear();
+}
+
+// Propagates the trail from the given position through either the core clauses or the others. The others stop after
+// the first literal that implies something, so that the core clauses get to go first again. Returns the falsified
+// clause on conflict.
+uint32_t ProofChecker::propagate(size_t &head, bool core_clauses) {
+    while (head < trail.size()) {
+        Literal falsified = negate(trail[head++]);
+        std::vector<uint32_t> &watchers = watches[falsified];
+        size_t assigned = trail.size();
+
+        size_t kept = 0;
+        for (size_t i = 0; i < watchers.size(); i++) {
+            uint32_t clause = watchers[i];
+            if (active[clause] == CLAUSE_RETIRED) continue;
+            if (active[clause] == CLAUSE_INACTIVE || core[clause] != core_clauses) {
+                watchers[kept++] = clause;
+                continue;
+            }
+            Literal *clause_literals = &literals[starts[clause]];
+            if (clause_literals[0] == falsified) std::swap(clause_literals[0], clause_literals[1]);
+            if (values[clause_literals[0]] == T) {
+                watchers[kept++] = clause;
+                continue;
+            }
+
+            bool moved = false;
+            for (size_t j = 2; j < size(clause); j++) {
+                if (values[clause_literals[j]] != F) {
+                    std::swap(clause_literals[1], clause_literals[j]);
+                    watches[clause_literals[1]].push_back(clause);
+                    moved = true;
+                    break;
+                }
+            }
+            if (moved) continue;
+
+            watchers[kept++] = clause;
+            if (values[clause_literals[0]] == F) {
+                for (i++; i < watchers.size(); i++) {
+                    watchers[kept++] = watchers[i];
+                }
+                watchers.resize(kept);
+                return clause;
+            }
+            assign(clause_literals[0], clause);
+        }
+        watchers.resize(kept);
+        if (!core_clauses && trail.size() > assigned) break;
+    }
+    return CLAUSE_NONE;
+}
+
+// Checks that the lemma follows from the active clauses by reverse unit propagation, and adds the clauses the
+// conflict depends on to the core.
+bool ProofChecker::check_lemma(uint32_t lemma) {
+    reset();
+    uint32_t conflict = CLAUSE_NONE;
+    for (size_t i = starts[lemma]; i < starts[lemma + 1]; i++) {
+        // A tautology always follows.
+        if (values[literals[i]] == T) return true;
+        assign(negate(literals[i]), CLAUSE_NONE);
+    }
+    for (const uint32_t &unit: units) {
+        if (active[unit] != CLAUSE_ACTIVE) continue;
+        Literal literal = literals[starts[unit]];
+        if (values[literal] == F) {
+            conflict = unit;
+            break;
+        }
+        if (values[literal] == U) assign(literal, unit);
+    }
+
+    // The other clauses only get to propagate once the core clauses have nothing left to propagate.
+    size_t core_head = 0;
+    size_t other_head = 0;
+    while (conflict == CLAUSE_NONE) {
+        conflict = propagate(core_head, true);
+        if (conflict != CLAUSE_NONE || other_head == trail.size()) break;
+        conflict = propagate(other_head, false);
+    }
+    if (conflict == CLAUSE_NONE) return false;
+
+    // Walk the trail back from the conflict, marking the reasons of the literals it depends on.
+    core[conflict] = 1;
+    for (size_t i = starts[conflict]; i < starts[conflict + 1]; i++) {
+        seen[var_of(literals[i])] = 1;
+    }
+    for (size_t i = trail.size(); i > 0; i--) {
+        Var variable = var_of(trail[i - 1]);
+        if (!seen[variable]) continue;
+        seen[variable] = 0;
+        uint32_t reason = reasons[variable];
+        if (reason == CLAUSE_NONE) continue;
+        core[reason] = 1;
+        for (size_t j = starts[reason]; j < starts[reason + 1]; j++) {
+            seen[var_of(literals[j])] = 1;
+        }
+    }
+    return true;
+}
+
+// Replays the proof forwards up to the empty clause, then steps back through it re-adding the deleted clauses and
+// removing the lemmas, checking the ones in the core against the clauses before them.
+bool ProofChecker::check_drat(const std::vector<char> &data, bool binary) {
+    std::unordered_map<uint64_t, std::vector<uint32_t>> index;
+    for (uint32_t clause = 0; clause < input_count; clause++) {
+        index[clause_hash(&literals[starts[clause]], &literals[starts[clause + 1]])].push_back(clause);
+    }
+
+    // Clauses added and deleted by every step, the deleted ones with the high bit set.
+    const uint32_t deletion_bit = 1u << 31;
+    std::vector<uint32_t> steps;
+    uint32_t empty_clause = CLAUSE_NONE;
+    ProofReader reader(data, binary);
+    while (empty_clause == CLAUSE_NONE && reader.next_step()) {
+        bool deletion = reader.deletion();
+        reader.read_literals(buffer);
+        if (!deletion) {
+            uint32_t clause = store(buffer);
+            lemmas_count++;
+            if (buffer.empty()) empty_clause = clause;
+            activate(clause);
+            index[clause_hash(buffer.data(), buffer.data() + buffer.size())].push_back(clause);
+            steps.push_back(clause);
+            continue;
+        }
+
+        // Deletions of clauses that aren't there are ignored.
+        std::sort(buffer.begin(), buffer.end());
+        buffer.erase(std::unique(buffer.begin(), buffer.end()), buffer.end());
+        auto candidates = index.find(clause_hash(buffer.data(), buffer.data() + buffer.size()));
+        if (candidates == index.end()) continue;
+        std::vector<uint32_t> &clauses = candidates->second;
+        for (size_t i = 0; i < clauses.size(); i++) {
+            uint32_t clause = clauses[i];
+            if (size(clause) != buffer.size()) continue;
+            // The watched literals may have been moved out of order.
+            std::vector<Literal> sorted(&literals[starts[clause]], &literals[starts[clause + 1]]);
+            std::sort(sorted.begin(), sorted.end());
+            if (sorted != buffer) continue;
+            active[clause] = CLAUSE_INACTIVE;
+            clauses[i] = clauses.back();
+            clauses.pop_back();
+            steps.push_back(clause | deletion_bit);
+            break;
+        }
+    }
+    if (empty_clause == CLAUSE_NONE) {
+        failure = "the proof doesn't derive the empty clause";
+        return false;
+    }
+
+    core[empty_clause] = 1;
+    for (size_t i = steps.size(); i > 0; i--) {
+        uint32_t clause = steps[i - 1] & ~deletion_bit;
+        if (steps[i - 1] & deletion_bit) {
+            active[clause] = CLAUSE_ACTIVE;
+            continue;
+        }
+        active[clause] = CLAUSE_RETIRED;
+        if (!core[clause]) continue;
+        checked_count++;
+        if (!check_lemma(clause)) {
+            failure = "lemma " + std::to_string(clause - input_count + 1) + " doesn't follow by unit propagation";
+            reset();
+            return false;
+        }
+    }
+    reset();
+    return true;
+}
+
+// Every step must be unit under the negated lemma and the hints before it, up to a falsified one.
+bool ProofChecker::check_lrat(const std::vector<char> &data, bool binary) {
+    std::vector<uint32_t> clause_of_id(input_count + 1, CLAUSE_NONE);
+    for (uint32_t clause = 0; clause < input_count; clause++) {
+        clause_of_id[clause + 1] = clause;
+    }
+    int64_t last_id = static_cast<int64_t>(input_count);
+
+    ProofReader reader(data, binary);
+    while (reader.next_step()) {
+        int64_t id = 0;
+        bool deletion = binary ? reader.deletion() : (id = reader.read_number(), reader.deletion());
+        if (deletion) {
+            int64_t deleted;
+            while ((deleted = reader.read_number()) != 0) {
+                if (deleted > 0 && deleted < static_cast<int64_t>(clause_of_id.size())) {
+                    clause_of_id[static_cast<size_t>(deleted)] = CLAUSE_NONE;
+                }
+            }
+            continue;
+        }
+        if (binary) id = reader.read_number();
+        if (id <= last_id) reader.fail("clause ids must increase");
+        last_id = id;
+
+        reader.read_literals(buffer);
+        uint32_t clause = store(buffer);
+        lemmas_count++;
+        checked_count++;
+        reset();
+        bool conflict = false;
+        for (size_t i = starts[clause]; i < starts[clause + 1] && !conflict; i++) {
+            conflict = values[literals[i]] == T;
+            if (!conflict) assign(negate(literals[i]), CLAUSE_NONE);
+        }
+
+        int64_t hint;
+        while ((hint = reader.read_number()) != 0) {
+            if (conflict) continue;
+            if (hint < 0) {
+                failure = "step " + std::to_string(id) + " is a RAT step, which isn't supported";
+                return false;
+            }
+            uint32_t hint_clause = hint < static_cast<int64_t>(clause_of_id.size()) ?
+                                   clause_of_id[static_cast<size_t>(hint)] : CLAUSE_NONE;
+            if (hint_clause == CLAUSE_NONE) {
+                failure = "step " + std::to_string(id) + " refers to missing clause " + std::to_string(hint);
+                return false;
+            }
+            Literal unit = LITERAL_NONE;
+            size_t unassigned = 0;
+            bool satisfied = false;
+            for (size_t i = starts[hint_clause]; i < starts[hint_clause + 1]; i++) {
+                satisfied = satisfied || values[literals[i]] == T;
+                if (values[literals[i]] == U) {
+                    unassigned++;
+                    unit = literals[i];
+                }
+            }
+            if (satisfied || unassigned > 1) {
+                failure = "hint " + std::to_string(hint) + " of step " + std::to_string(id) + " isn't unit";
+                return false;
+            }
+            if (unassigned == 0) {
+                conflict = true;
+            } else {
+                assign(unit, hint_clause);
+            }
+        }
+        reset();
+        if (!conflict) {
+            failure = "the hints of step " + std::to_string(id) + " don't lead to a conflict";
+            return false;
+        }
+
+        auto index = static_cast<size_t>(id);
+        if (clause_of_id.size() <= index) clause_of_id.resize(index + 1, CLAUSE_NONE);
+        clause_of_id[index] = clause;
+        if (size(clause) == 0) return true;
+    }
+    failure = "the proof doesn't derive the empty clause";
+    return false;
+}
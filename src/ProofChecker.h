@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DimacsParser.h"
+#include "Proof.h"
+
+// Checks a proof of unsatisfiability against the input clauses, in a clause database of its own. DRAT proofs are
+// checked backwards from the empty clause, so that only the lemmas the refutation depends on are checked. Their
+// reverse unit propagation goes through the clauses already known to be needed first, which keeps that set small.
+// LRAT proofs are checked forwards, every step by propagating its hints in order. Only RUP steps are accepted,
+// which is all the solver produces. Deletions are honored, including those of unit clauses, unlike in checkers that
+// ignore them; the solver never logs one, so its proofs don't depend on the difference.
+class ProofChecker {
+public:
+    explicit ProofChecker(const Cnf &cnf);
+
+    // Throws ProofError if the proof can't be read or is malformed. Returns false if one of its steps doesn't
+    // follow, or if it never derives the empty clause, with the reason in `failure`.
+    bool check(const std::string &path, ProofFormat format);
+
+    std::string failure;
+    // Lemmas added by the proof, and those of them that were checked.
+    size_t lemmas_count = 0;
+    size_t checked_count = 0;
+
+private:
+    // Clauses one after the other, the input ones first, with their literals sorted and without duplicates. The
+    // watched literals of a clause are its first two.
+    std::vector<Literal> literals;
+    std::vector<size_t> starts;
+    std::vector<uint8_t> active;
+    // Set for the clauses the refutation is known to depend on.
+    std::vector<uint8_t> core;
+    std::vector<uint32_t> units;
+    std::vector<std::vector<uint32_t>> watches;
+    size_t input_count = 0;
+    bool empty_input = false;
+
+    // Assignment of the current check, indexed by Literal, and the reasons of the variables, indexed by Var.
+    std::vector<LiteralValue> values;
+    std::vector<uint32_t> reasons;
+    std::vector<uint8_t> seen;
+    std::vector<Literal> trail;
+
+    std::vector<Literal> buffer;
+
+    uint32_t store(std::vector<Literal> &);
+
+    size_t size(uint32_t clause) const {
+        return starts[clause + 1] - starts[clause];
+    }
+
+    void activate(uint32_t);
+
+    void ensure_variables(size_t);
+
+    void assign(Literal, uint32_t);
+
+    void reset();
+
+    uint32_t propagate(size_t &, bool);
+
+    bool check_lemma(uint32_t);
+
+    bool check_drat(const std::vector<char> &, bool);
+
+    bool check_lrat(const std::vector<char> &, bool);
+};
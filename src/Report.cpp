@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <iomanip>
+
+#include "Report.h"
+
+namespace {
+
+    // Writes the statistics as the members of a JSON object.
+    void write_statistics(std::ostream &output, const Report &report, const SearchStats &stats) {
+        long conflicts = std::max(1L, stats.conflicts);
+        output << std::setprecision(3) << R"("Decisions": )" << stats.decisions << ", " <<
+               R"("Propagations": )" << stats.propagations << ", " <<
+               R"("Conflicts": )" << stats.conflicts << ", " <<
+               R"("Restarts": )" << stats.restarts << ", " <<
+               R"("LearnedClauses": )" << stats.learned_clauses << ", " <<
+               R"("DeletedClauses": )" << stats.deleted_clauses << ", " <<
+               R"("AverageLBD": )" << static_cast<double>(stats.learned_lbd_sum) / conflicts << ", " <<
+               R"("AverageTrail": )" << static_cast<double>(stats.conflict_trail_sum) / conflicts << ", " <<
+               R"("ParseTime": )" << report.parse_time << ", " <<
+               R"("PreprocessTime": )" << report.preprocess_time << ", " <<
+               R"("SearchTime": )" << report.search_time;
+#ifdef PROFILE
+        output << ", " << R"("PropagationTime": )" << stats.propagation_time << ", " <<
+               R"("AnalysisTime": )" << stats.analysis_time << ", " <<
+               R"("ReductionTime": )" << stats.reduction_time << ", " <<
+               R"("InprocessingTime": )" << stats.inprocessing_time;
+#endif
+    }
+}
+
+void write_report(std::ostream &output, const Report &report, const Formula &formula) {
+    output << R"({"Instance": ")" << report.instance << "\", " <<
+           R"("Time": ")" << std::fixed << std::setprecision(2) << report.time << "\", " <<
+           R"("Result": ")" << report.result << "\"";
+    if (!report.proof_status.empty()) output << ", " << R"("Proof": ")" << report.proof_status << "\"";
+    output << ", " << R"("Statistics": {)";
+    write_statistics(output, report, formula.stats);
+    output << "}";
+
+    size_t input_variables = formula.variables_count() - formula.auxiliary_variables_count;
+    if (report.result == "SAT") {
+        output << ", " << R"("Solution": ")";
+        std::string solution;
+        for (Var variable = 0; variable < input_variables; variable++) {
+            const auto &value = formula.values[variable];
+
+            solution.append(std::to_string(variable + 1));
+            solution.append(" ");
+            if (value != U) {
+                solution.append(value == T ? "true" : "false");
+            } else {
+                solution.append("true");
+            }
+            solution.append(" ");
+        }
+        if (!solution.empty()) solution.pop_back();
+        output << solution << "\"";
+    } else if (report.result == "UNKNOWN") {
+        // The longest assignment the search reached without a conflict, as DIMACS literals.
+        output << ", " << R"("BestAssignment": ")";
+        std::string assignment;
+        for (Var variable = 0; variable < input_variables; variable++) {
+            const auto &value = formula.best_phases[variable];
+            if (value == U) continue;
+            assignment.append(value == T ? "" : "-");
+            assignment.append(std::to_string(variable + 1));
+            assignment.append(" ");
+        }
+        if (!assignment.empty()) assignment.pop_back();
+        output << assignment << "\"";
+    }
+    output << "}" << std::endl;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+
+#include "Formula.h"
+
+// Outcome of solving one instance.
+struct Report {
+    std::string instance;
+    // SAT, UNSAT, or UNKNOWN when the search was stopped.
+    std::string result;
+    // VERIFIED or REJECTED when the proof was checked, empty otherwise.
+    std::string proof_status;
+    // Wall times in seconds; `time` covers preprocessing and search.
+    double time = 0;
+    double parse_time = 0;
+    double preprocess_time = 0;
+    double search_time = 0;
+};
+
+// Writes the report as a single JSON line, with the search statistics of the formula, its model if it is SAT, and the
+// best partial assignment found if it is UNKNOWN.
+void write_report(std::ostream &output, const Report &report, const Formula &formula);
@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "DimacsParser.h"
+#include "Preprocessor.h"
+#include "Report.h"
+#include "Server.h"
+#include "SymmetryBreaker.h"
+#include "Verifier.h"
+#include "strategies/branching/VSIDSStrategy.h"
+
+// Builds can leave out checking models against the job, which keeps a copy of its clauses.
+#ifndef VERIFY
+#define VERIFY true
+#endif
+
+namespace {
+
+    // Splits what is read from a file descriptor into lines, without their line breaks.
+    class LineReader {
+    public:
+        explicit LineReader(int fd) : fd(fd) {}
+
+        // Returns false at the end of the input.
+        bool next(std::string &line) {
+            while (true) {
+                size_t end = buffer.find('\n', position);
+                if (end != std::string::npos) {
+                    line.assign(buffer, position, end - position);
+                    position = end + 1;
+                    if (!line.empty() && line.back() == '\r') line.pop_back();
+                    return true;
+                }
+                buffer.erase(0, position);
+                position = 0;
+                char chunk[1 << 16];
+                ssize_t count;
+                do {
+                    count = read(fd, chunk, sizeof(chunk));
+                } while (count < 0 && errno == EINTR);
+                if (count <= 0) {
+                    // A last line without its line break still counts.
+                    if (buffer.empty()) return false;
+                    line.swap(buffer);
+                    buffer.clear();
+                    return true;
+                }
+                buffer.append(chunk, static_cast<size_t>(count));
+            }
+        }
+
+    private:
+        int fd;
+        std::string buffer;
+        size_t position = 0;
+    };
+
+    double seconds_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::string escape(const std::string &text) {
+        std::string escaped;
+        for (const char &c: text) {
+            if (c == '"' || c == '\\') escaped.push_back('\\');
+            escaped.push_back(c == '\n' ? ' ' : c);
+        }
+        return escaped;
+    }
+}
+
+void Server::Client::send(const std::string &text) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t written = 0;
+    while (written < text.size()) {
+        ssize_t count = write(fd, text.data() + written, text.size() - written);
+        if (count < 0 && errno == EINTR) continue;
+        // The client is gone, its answers are dropped.
+        if (count <= 0) return;
+        written += static_cast<size_t>(count);
+    }
+}
+
+Server::Server(ServerOptions options) : options(std::move(options)) {
+    for (size_t i = 0; i < this->options.workers; i++) {
+        workers.emplace_back(new Worker());
+    }
+}
+
+bool Server::serve() {
+    // Writing to a client that hung up must not end the server.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<std::thread> threads;
+    for (auto &worker: workers) {
+        threads.emplace_back(&Server::work, this, std::ref(*worker));
+    }
+
+    bool served = true;
+    if (options.socket_path.empty()) {
+        read_client(std::make_shared<Client>(STDOUT_FILENO));
+    } else {
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        served = listener >= 0 && options.socket_path.size() < sizeof(address.sun_path);
+        if (served) {
+            std::strncpy(address.sun_path, options.socket_path.c_str(), sizeof(address.sun_path) - 1);
+            unlink(options.socket_path.c_str());
+            served = bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0 &&
+                     listen(listener, SOMAXCONN) == 0;
+        }
+        if (!served) {
+            std::cerr << "cannot listen on " << options.socket_path << ": " << std::strerror(errno) << std::endl;
+        }
+        while (served) {
+            int connection = accept(listener, nullptr, nullptr);
+            if (connection < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                std::cerr << "cannot accept connections: " << std::strerror(errno) << std::endl;
+                served = false;
+                break;
+            }
+            join_finished_readers();
+            long id;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                id = readers_count++;
+                reading[id] = connection;
+            }
+            // The connection is closed once its reader is done and the last of its jobs is answered.
+            readers.emplace_back(id, std::thread([this, id, connection]() {
+                std::shared_ptr<Client> client(new Client(connection), [](Client *done) {
+                    close(done->fd);
+                    delete done;
+                });
+                read_client(client);
+                std::lock_guard<std::mutex> lock(mutex);
+                reading.erase(id);
+            }));
+        }
+        if (listener >= 0) close(listener);
+    }
+
+    // Readers still waiting for their clients see the end of their input, a job they were receiving is dropped.
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto &connection: reading) {
+            shutdown(connection.second, SHUT_RD);
+        }
+    }
+    for (auto &reader: readers) {
+        reader.second.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    available.notify_all();
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    return served;
+}
+
+// Readers that left `reading` have nothing left to do but release their client.
+void Server::join_finished_readers() {
+    std::vector<std::pair<long, std::thread>>::iterator finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = std::partition(readers.begin(), readers.end(), [&](const std::pair<long, std::thread> &reader) {
+            return reading.count(reader.first) > 0;
+        });
+    }
+    for (auto reader = finished; reader != readers.end(); reader++) {
+        reader->second.join();
+    }
+    readers.erase(finished, readers.end());
+}
+
+void Server::read_client(const std::shared_ptr<Client> &client) {
+    LineReader reader(client->fd == STDOUT_FILENO ? STDIN_FILENO : client->fd);
+    std::string line;
+    while (reader.next(line)) {
+        std::istringstream words(line);
+        std::string command;
+        words >> command;
+        if (command.empty()) continue;
+        if (command == "stats") {
+            client->send(stats());
+            continue;
+        }
+        if (command != "job") {
+            client->send(R"({"Error": "unknown command ')" + escape(command) + "'\"}\n");
+            continue;
+        }
+
+        Job job;
+        double timeout;
+        words >> job.name;
+        job.timeout = words >> timeout ? timeout : options.timeout;
+        bool ended = false;
+        while (reader.next(line)) {
+            if (line == "end") {
+                ended = true;
+                break;
+            }
+            job.text.append(line);
+            job.text.push_back('\n');
+        }
+        // A job cut off by the end of the connection is dropped.
+        if (!ended) break;
+        job.received = std::chrono::steady_clock::now();
+        job.client = client;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs_count++;
+        if (job.name.empty()) job.name = "job-" + std::to_string(jobs_count);
+        queue.push_back(std::move(job));
+        available.notify_one();
+    }
+}
+
+void Server::work(Worker &worker) {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [&]() { return !queue.empty() || closing; });
+            if (queue.empty()) return;
+            job = std::move(queue.front());
+            queue.pop_front();
+            running_count++;
+        }
+
+        std::string answer;
+        try {
+            answer = solve(job, worker);
+        } catch (const std::exception &error) {
+            // Running out of memory or any other failure ends the job, not the server.
+            answer = R"({"Instance": ")" + escape(job.name) + R"(", "Error": ")" + escape(error.what()) + "\"}\n";
+        }
+        job.client->send(answer);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        running_count--;
+        completed_count++;
+        double latency = seconds_since(job.received);
+        latency_sum += latency;
+        latency_max = std::max(latency_max, latency);
+    }
+}
+
+// Solves the job like the solver does a single instance, with the arenas of the worker.
+std::string Server::solve(Job &job, Worker &worker) {
+    auto start = std::chrono::steady_clock::now();
+    Formula formula;
+    formula.arena = std::move(worker.arena);
+    formula.spare_arena = std::move(worker.spare_arena);
+    formula.verbose = false;
+    formula.limits = options.limits;
+    // Their memory stays with the worker for the next job.
+    auto keep_arenas = [&]() {
+        worker.arena = std::move(formula.arena);
+        worker.arena.clear();
+        worker.spare_arena = std::move(formula.spare_arena);
+    };
+    // The time limit starts when the job is taken off the queue.
+    if (job.timeout > 0) {
+        formula.limits.deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(job.timeout));
+    }
+
+    std::ostringstream answer;
+    Report report;
+    report.instance = escape(job.name);
+    // Models are checked against the clauses as they were read, before preprocessing rewrites them.
+    Cnf cnf;
+    try {
+        if (VERIFY) {
+            DimacsParser::parse_text(job.text, job.name, formula, cnf);
+        } else {
+            DimacsParser::parse_text(job.text, job.name, formula);
+        }
+    } catch (const ParseError &error) {
+        keep_arenas();
+        answer << R"({"Instance": ")" << escape(job.name) << R"(", "Error": ")" << escape(error.what()) << "\"}\n";
+        return answer.str();
+    }
+    // The text isn't needed anymore.
+    std::string().swap(job.text);
+
+    auto preprocess_start = std::chrono::steady_clock::now();
+    Preprocessor(formula).preprocess();
+    if (options.break_symmetries) {
+        SymmetryBreaker(formula).break_symmetries();
+    }
+    auto search_start = std::chrono::steady_clock::now();
+    VSIDSStrategy strategy;
+    std::unique_ptr<RestartStrategy> restarts = make_restart_strategy(options.restart_policy, LUBY_UNIT);
+    bool sat = formula.solve(strategy, *restarts);
+    if (VERIFY && sat && !Verifier(std::move(cnf)).verify_model(formula.values)) {
+        keep_arenas();
+        answer << R"({"Instance": ")" << escape(job.name) << R"(", "Error": "the model doesn't satisfy the input"})"
+               << "\n";
+        return answer.str();
+    }
+    // A search stopped by the time limit returns false without refuting the formula.
+    report.result = sat ? "SAT" : formula.empty_clause ? "UNSAT" : "UNKNOWN";
+    report.parse_time = std::chrono::duration<double>(preprocess_start - start).count();
+    report.preprocess_time = std::chrono::duration<double>(search_start - preprocess_start).count();
+    report.search_time = seconds_since(search_start);
+    report.time = seconds_since(preprocess_start);
+    write_report(answer, report, formula);
+
+    keep_arenas();
+    return answer.str();
+}
+
+std::string Server::stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ostringstream output;
+    output << std::fixed << std::setprecision(3) <<
+           R"({"Queued": )" << queue.size() << ", " <<
+           R"("Running": )" << running_count << ", " <<
+           R"("Completed": )" << completed_count << ", " <<
+           R"("AverageLatency": )" << latency_sum / static_cast<double>(std::max(1L, completed_count)) << ", " <<
+           R"("MaxLatency": )" << latency_max << "}\n";
+    return output.str();
+}
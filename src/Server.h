@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Formula.h"
+#include "strategies/restart/RestartStrategy.h"
+
+struct ServerOptions {
+    size_t workers = 1;
+    // Default time limit of a job in seconds, 0 for none.
+    double timeout = 0;
+    // Limits of the search of every job, apart from its deadline.
+    SearchLimits limits;
+    bool break_symmetries = true;
+    // Unix socket to listen on; standard input and output are served when empty.
+    std::string socket_path;
+    RestartPolicy restart_policy = RESTART_ALTERNATING;
+};
+
+// Solves a stream of jobs on a fixed pool of worker threads, without starting a process per instance. Clients send
+// lines of a simple protocol, over standard input or a connection to a Unix socket:
+//
+//   job NAME [TIMEOUT]    starts a job, whose DIMACS text follows up to a line with just "end"
+//   stats                 asks for the queue depth, the number of jobs running and done, and their latency
+//
+// Every job is answered on its connection by the JSON line the solver prints for a single instance, in the order
+// the jobs finish. Jobs that run out of time are UNKNOWN, and models are checked against the jobs unless the build
+// leaves it out. Each worker keeps its clause arenas between jobs.
+class Server {
+public:
+    explicit Server(ServerOptions options);
+
+    Server(const Server &) = delete;
+
+    Server &operator=(const Server &) = delete;
+
+    // Serves standard input until it ends and every job is answered, or the socket until the process is killed or
+    // a connection can't be accepted. Returns false if the socket fails.
+    bool serve();
+
+private:
+    // Connection the jobs came in on and their answers go out to.
+    struct Client {
+        int fd;
+        std::mutex mutex;
+
+        explicit Client(int fd) : fd(fd) {}
+
+        void send(const std::string &text);
+    };
+
+    struct Job {
+        std::string name;
+        std::string text;
+        double timeout;
+        std::chrono::steady_clock::time_point received;
+        std::shared_ptr<Client> client;
+    };
+
+    struct Worker {
+        ClauseArena arena;
+        ClauseArena spare_arena;
+    };
+
+    ServerOptions options;
+    std::vector<std::unique_ptr<Worker>> workers;
+    // Threads reading from the socket connections, by id. They are joined before the server returns.
+    std::vector<std::pair<long, std::thread>> readers;
+
+    // Guards the queue and the counters.
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque<Job> queue;
+    bool closing = false;
+    size_t running_count = 0;
+    long completed_count = 0;
+    long jobs_count = 0;
+    // Latency from receiving a job to answering it, in seconds.
+    double latency_sum = 0;
+    double latency_max = 0;
+    // Connections of the readers still reading from them, by reader id, shut down when the server stops.
+    std::map<long, int> reading;
+    long readers_count = 0;
+
+    void read_client(const std::shared_ptr<Client> &client);
+
+    void join_finished_readers();
+
+    void work(Worker &worker);
+
+    std::string solve(Job &job, Worker &worker);
+
+    std::string stats();
+};
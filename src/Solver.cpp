@@ -0,0 +1,45 @@
+#include "Solver.h"
+
+void Solver::add_clause(const std::vector<long> &clause) {
+    literals.clear();
+    for (const long &dimacs_literal: clause) {
+        Literal literal = from_dimacs(dimacs_literal);
+        solver_formula.set_variables_count(var_of(literal) + 1);
+        literals.push_back(literal);
+    }
+    solver_formula.add_clause(literals);
+}
+
+bool Solver::solve(const std::vector<long> &assumptions) {
+    literals.clear();
+    for (const long &dimacs_literal: assumptions) {
+        Literal literal = from_dimacs(dimacs_literal);
+        solver_formula.set_variables_count(var_of(literal) + 1);
+        literals.push_back(literal);
+    }
+    return solver_formula.solve(strategy, restarts, literals);
+}
+
+LiteralValue Solver::value(long literal) const {
+    Literal solver_literal = from_dimacs(literal);
+    if (var_of(solver_literal) >= solver_formula.variables_count()) return U;
+    return solver_formula.value(solver_literal);
+}
+
+std::vector<long> Solver::model() const {
+    std::vector<long> true_literals;
+    true_literals.reserve(solver_formula.variables_count());
+    for (Var variable = 0; variable < solver_formula.variables_count(); variable++) {
+        // Unassigned variables are reported as true.
+        true_literals.push_back(to_dimacs(make_literal(variable, solver_formula.values[variable] == F)));
+    }
+    return true_literals;
+}
+
+std::vector<long> Solver::failed_assumptions() const {
+    std::vector<long> failed;
+    for (const Literal &literal: solver_formula.failed_assumptions) {
+        failed.push_back(to_dimacs(literal));
+    }
+    return failed;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+
+#include "Formula.h"
+#include "strategies/branching/VSIDSStrategy.h"
+#include "strategies/restart/AlternatingStrategy.h"
+
+// Incremental interface for embedding the solver, with literals given as DIMACS integers. Clauses can be added
+// between searches, and learned clauses and branching scores carry over from one search to the next.
+class Solver {
+public:
+    Solver() {
+        // Clauses added later may mention any variable.
+        solver_formula.allow_elimination = false;
+    }
+
+    Solver(const Solver &) = delete;
+
+    Solver &operator=(const Solver &) = delete;
+
+    // Adds a clause over any variables, new ones included.
+    void add_clause(const std::vector<long> &clause);
+
+    // Searches for a model satisfying the assumptions, which only hold for this call. The limits and the interrupt
+    // of the formula also make it return false, without an answer.
+    bool solve(const std::vector<long> &assumptions = {});
+
+    // Whether the last search was stopped by a limit or the interrupt rather than failing.
+    bool stopped() const {
+        return solver_formula.stopped;
+    }
+
+    // Value of the literal in the model found by the last successful search.
+    LiteralValue value(long literal) const;
+
+    // Model of the last successful search as a list of true literals, one per variable.
+    std::vector<long> model() const;
+
+    // After a failed search, a subset of the assumptions that is already unsatisfiable together with the formula.
+    // It is empty if the formula is unsatisfiable on its own.
+    std::vector<long> failed_assumptions() const;
+
+    Formula &formula() {
+        return solver_formula;
+    }
+
+private:
+    Formula solver_formula;
+    VSIDSStrategy strategy;
+    AlternatingStrategy restarts;
+
+    std::vector<Literal> literals;
+};
@@ -0,0 +1,405 @@
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+#include "SymmetryBreaker.h"
+
+// Vertex visits the search for generators may make in total.
+#define SYMMETRY_BUDGET 50000000
+// Branches of a level that may fail before the search moves on to the level above.
+#define FAILED_BRANCHES_LIMIT 16
+// Variables of a generator compared by its lex-leader clauses.
+#define LEX_LEADER_SIZE 64
+// Vertices that may be kept in the partitions saved along the first path.
+#define CHECKPOINT_LIMIT 4000000
+
+namespace {
+
+    const uint32_t CELL_NONE = UINT32_MAX;
+}
+
+size_t SymmetryBreaker::break_symmetries() {
+    if (formula.empty_clause) return 0;
+    build_graph();
+    if (literal_vertices == 0) return 0;
+
+    // Literals and clauses start out in cells of their own.
+    Partition root;
+    root.elements.resize(vertices);
+    std::iota(root.elements.begin(), root.elements.end(), 0);
+    root.positions = root.elements;
+    root.cell_of.resize(vertices);
+    root.cell_ends.assign(vertices, 0);
+    for (uint32_t vertex = 0; vertex < vertices; vertex++) {
+        root.cell_of[vertex] = vertex < literal_vertices ? 0 : literal_vertices;
+    }
+    queued.assign(vertices, 0);
+    hits.assign(vertices, 0);
+    // There are clauses whenever there are literals.
+    root.cell_ends[0] = literal_vertices;
+    root.cell_ends[literal_vertices] = vertices;
+    for (const uint32_t &cell: {0u, literal_vertices}) {
+        queued[cell] = 1;
+        splitters.push_back(cell);
+    }
+    refine(root);
+
+    // The partitions of the first path are saved every `stride` levels, those in between are replayed.
+    size_t stride = 1 + variables.size() * vertices / CHECKPOINT_LIMIT;
+    std::vector<Partition> checkpoints;
+    Partition leaf = root;
+    uint32_t cell;
+    while ((cell = target_cell(leaf)) != CELL_NONE && work < SYMMETRY_BUDGET) {
+        if (path.size() % stride == 0) checkpoints.push_back(leaf);
+        path_cells.push_back(cell);
+        path_candidates.emplace_back(leaf.elements.begin() + cell, leaf.elements.begin() + leaf.cell_ends[cell]);
+        path.push_back(leaf.elements[cell]);
+        individualize(leaf, path.back());
+        refine(leaf);
+    }
+    if (cell != CELL_NONE) return 0;
+
+    // Deeper levels first, so that the generators found so far fix the first path above the level. Candidates in
+    // the orbit of the vertex of the first path lead to leaves that are already accounted for.
+    orbits.resize(literal_vertices);
+    std::iota(orbits.begin(), orbits.end(), 0);
+    image.resize(literal_vertices);
+    clause_stamps.assign(vertices - literal_vertices, 0);
+    for (size_t level = path.size(); level-- > 0 && work < SYMMETRY_BUDGET;) {
+        Partition prefix = checkpoints[level / stride];
+        for (size_t i = level / stride * stride; i < level; i++) {
+            individualize(prefix, path[i]);
+            refine(prefix);
+        }
+        size_t failures = 0;
+        for (const uint32_t &candidate: path_candidates[level]) {
+            if (work >= SYMMETRY_BUDGET || failures == FAILED_BRANCHES_LIMIT) break;
+            if (orbit(candidate) == orbit(path[level])) continue;
+            Partition branch = prefix;
+            individualize(branch, candidate);
+            refine(branch);
+            if (!descend(branch, level + 1) || !automorphism(leaf, branch)) {
+                failures++;
+                continue;
+            }
+            std::vector<uint32_t> generator;
+            for (uint32_t vertex = 0; vertex < literal_vertices; vertex++) {
+                if (image[vertex] == vertex) continue;
+                generator.push_back(vertex);
+                generator.push_back(image[vertex]);
+                orbits[orbit(vertex)] = orbit(image[vertex]);
+            }
+            generators.push_back(std::move(generator));
+        }
+    }
+
+    size_t clauses_count = formula.clauses.size();
+    for (const std::vector<uint32_t> &generator: generators) {
+        add_breaking_clauses(generator);
+    }
+    if (formula.verbose) {
+        std::cerr << "# SYMMETRY GENERATORS: " << generators.size()
+                  << " # BREAKING CLAUSES: " << formula.clauses.size() - clauses_count << std::endl;
+    }
+    return generators.size();
+}
+
+// The graph of the clauses left by the top-level assignment; variables that don't occur in any of them are fixed
+// by every automorphism that matters, so they are left out.
+void SymmetryBreaker::build_graph() {
+    std::vector<Literal> literals;
+    std::vector<uint32_t> starts(1, 0);
+    for (const ClauseRef &ref: formula.clauses) {
+        const Clause &clause = formula.arena[ref];
+        size_t start = literals.size();
+        bool satisfied = false;
+        for (size_t i = 0; i < clause.size && !satisfied; i++) {
+            LiteralValue literal_value = formula.value(clause[i]);
+            satisfied = literal_value == T;
+            if (literal_value == U) literals.push_back(clause[i]);
+        }
+        if (satisfied) {
+            literals.resize(start);
+        } else {
+            starts.push_back(static_cast<uint32_t>(literals.size()));
+        }
+    }
+
+    std::vector<uint32_t> index_of(formula.variables_count(), UINT32_MAX);
+    for (const Literal &literal: literals) {
+        index_of[var_of(literal)] = 0;
+    }
+    for (Var variable = 0; variable < formula.variables_count(); variable++) {
+        if (index_of[variable] == UINT32_MAX) continue;
+        index_of[variable] = static_cast<uint32_t>(variables.size());
+        variables.push_back(variable);
+    }
+    literal_vertices = static_cast<uint32_t>(2 * variables.size());
+    uint32_t clauses_count = static_cast<uint32_t>(starts.size() - 1);
+    vertices = literal_vertices + clauses_count;
+
+    clause_starts = starts;
+    clause_vertices.resize(literals.size());
+    for (size_t i = 0; i < literals.size(); i++) {
+        clause_vertices[i] = 2 * index_of[var_of(literals[i])] + is_negative(literals[i]);
+    }
+    for (uint32_t clause = 0; clause < clauses_count; clause++) {
+        std::sort(clause_vertices.begin() + clause_starts[clause], clause_vertices.begin() + clause_starts[clause + 1]);
+    }
+    sorted_clauses.resize(clauses_count);
+    std::iota(sorted_clauses.begin(), sorted_clauses.end(), 0);
+    std::sort(sorted_clauses.begin(), sorted_clauses.end(), [&](uint32_t a, uint32_t b) {
+        return std::lexicographical_compare(
+                clause_vertices.begin() + clause_starts[a], clause_vertices.begin() + clause_starts[a + 1],
+                clause_vertices.begin() + clause_starts[b], clause_vertices.begin() + clause_starts[b + 1]);
+    });
+
+    // Every literal is joined to its negation and to its clauses.
+    edge_starts.assign(vertices + 1, 0);
+    for (uint32_t vertex = 0; vertex < literal_vertices; vertex++) {
+        edge_starts[vertex + 1] = 1;
+    }
+    for (uint32_t clause = 0; clause < clauses_count; clause++) {
+        for (uint32_t i = clause_starts[clause]; i < clause_starts[clause + 1]; i++) {
+            edge_starts[clause_vertices[i] + 1]++;
+        }
+        edge_starts[literal_vertices + clause + 1] = clause_starts[clause + 1] - clause_starts[clause];
+    }
+    std::partial_sum(edge_starts.begin(), edge_starts.end(), edge_starts.begin());
+    edges.resize(edge_starts.back());
+    std::vector<uint32_t> filled(edge_starts.begin(), edge_starts.end() - 1);
+    for (uint32_t vertex = 0; vertex < literal_vertices; vertex++) {
+        edges[filled[vertex]++] = vertex ^ 1;
+    }
+    for (uint32_t clause = 0; clause < clauses_count; clause++) {
+        for (uint32_t i = clause_starts[clause]; i < clause_starts[clause + 1]; i++) {
+            edges[filled[clause_vertices[i]]++] = literal_vertices + clause;
+            edges[filled[literal_vertices + clause]++] = clause_vertices[i];
+        }
+    }
+}
+
+// Splits the cells by the number of neighbors their vertices have in each queued splitter cell, until none is left.
+// Cells are split and queued in the order of their positions, so that the result doesn't depend on how the vertices
+// are numbered, only on where they are in the partition.
+void SymmetryBreaker::refine(Partition &partition) {
+    for (size_t head = 0; head < splitters.size(); head++) {
+        uint32_t splitter = splitters[head];
+        queued[splitter] = 0;
+        for (uint32_t i = splitter; i < partition.cell_ends[splitter]; i++) {
+            uint32_t vertex = partition.elements[i];
+            for (uint32_t j = edge_starts[vertex]; j < edge_starts[vertex + 1]; j++) {
+                if (hits[edges[j]]++ == 0) touched.push_back(edges[j]);
+            }
+            work += edge_starts[vertex + 1] - edge_starts[vertex];
+        }
+
+        std::sort(touched.begin(), touched.end(), [&](uint32_t a, uint32_t b) {
+            return partition.cell_of[a] < partition.cell_of[b];
+        });
+        for (size_t begin = 0, end; begin < touched.size(); begin = end) {
+            uint32_t cell = partition.cell_of[touched[begin]];
+            for (end = begin + 1; end < touched.size() && partition.cell_of[touched[end]] == cell; end++);
+            split(partition, cell, touched.data() + begin, touched.data() + end);
+        }
+        for (const uint32_t &vertex: touched) {
+            hits[vertex] = 0;
+        }
+        touched.clear();
+    }
+    splitters.clear();
+}
+
+// Splits a cell by the hits of its vertices, given those that have any, in increasing order of hits.
+void SymmetryBreaker::split(Partition &partition, uint32_t cell, const uint32_t *begin, const uint32_t *end) {
+    uint32_t cell_end = partition.cell_ends[cell];
+    if (cell_end - cell == 1) return;
+
+    // The vertices without hits stay in front, the others move to the back of the cell.
+    uint32_t back = cell_end;
+    for (const uint32_t *vertex = begin; vertex != end; vertex++) {
+        back--;
+        uint32_t position = partition.positions[*vertex];
+        uint32_t other = partition.elements[back];
+        partition.elements[position] = other;
+        partition.positions[other] = position;
+        partition.elements[back] = *vertex;
+        partition.positions[*vertex] = back;
+    }
+    std::sort(partition.elements.begin() + back, partition.elements.begin() + cell_end, [&](uint32_t a, uint32_t b) {
+        return hits[a] < hits[b];
+    });
+    for (uint32_t i = back; i < cell_end; i++) {
+        partition.positions[partition.elements[i]] = i;
+    }
+
+    auto key = [&](uint32_t position) {
+        return position < back ? 0 : hits[partition.elements[position]];
+    };
+    uint32_t largest = cell;
+    uint32_t start = cell;
+    for (uint32_t i = cell + 1; i <= cell_end; i++) {
+        if (i < cell_end && key(i) == key(start)) continue;
+        partition.cell_ends[start] = i;
+        if (start != cell) {
+            for (uint32_t j = start; j < i; j++) {
+                partition.cell_of[partition.elements[j]] = start;
+            }
+        }
+        if (i - start > partition.cell_ends[largest] - largest) largest = start;
+        start = i;
+    }
+
+    // A cell that wasn't queued yet can leave out its largest part, which adds nothing to the other parts and the
+    // refinement that made the cell equitable.
+    bool was_queued = queued[cell];
+    for (start = cell; start < cell_end; start = partition.cell_ends[start]) {
+        if (queued[start] || (!was_queued && start == largest)) continue;
+        queued[start] = 1;
+        splitters.push_back(start);
+    }
+}
+
+// Moves the vertex to a cell of its own in front of the rest of its cell.
+void SymmetryBreaker::individualize(Partition &partition, uint32_t vertex) {
+    uint32_t cell = partition.cell_of[vertex];
+    uint32_t cell_end = partition.cell_ends[cell];
+    if (cell_end - cell == 1) return;
+
+    uint32_t position = partition.positions[vertex];
+    uint32_t first = partition.elements[cell];
+    partition.elements[position] = first;
+    partition.positions[first] = position;
+    partition.elements[cell] = vertex;
+    partition.positions[vertex] = cell;
+
+    partition.cell_ends[cell] = cell + 1;
+    partition.cell_ends[cell + 1] = cell_end;
+    for (uint32_t i = cell + 1; i < cell_end; i++) {
+        partition.cell_of[partition.elements[i]] = cell + 1;
+    }
+    queued[cell] = 1;
+    splitters.push_back(cell);
+}
+
+// First cell of literals with more than one vertex. Literals and clauses never share a cell, and once the literals
+// are discrete the clauses they are in are fixed as well.
+uint32_t SymmetryBreaker::target_cell(const Partition &partition) const {
+    for (uint32_t cell = 0; cell < literal_vertices; cell = partition.cell_ends[cell]) {
+        if (partition.cell_ends[cell] - cell > 1) return cell;
+    }
+    return CELL_NONE;
+}
+
+// Follows the first path from the given level down to a discrete partition, individualizing the vertex of the first
+// path where it is in the cell to split, and the first vertex of the cell where it isn't.
+bool SymmetryBreaker::descend(Partition &partition, size_t level) {
+    while (work < SYMMETRY_BUDGET) {
+        uint32_t cell = target_cell(partition);
+        if (cell == CELL_NONE) return level == path.size();
+        if (level == path.size() || cell != path_cells[level] ||
+            partition.cell_ends[cell] - cell != path_candidates[level].size()) {
+            return false;
+        }
+        uint32_t vertex = path[level];
+        if (partition.cell_of[vertex] != cell) vertex = partition.elements[cell];
+        individualize(partition, vertex);
+        refine(partition);
+        level++;
+    }
+    return false;
+}
+
+// Checks the permutation mapping the literals of one discrete partition onto those in the same positions of the
+// other against the clauses, which are only looked at if they contain a literal it moves. Leaves it in `image`.
+bool SymmetryBreaker::automorphism(const Partition &first, const Partition &other) {
+    for (uint32_t i = 0; i < literal_vertices; i++) {
+        image[first.elements[i]] = other.elements[i];
+    }
+    stamp++;
+    for (uint32_t vertex = 0; vertex < literal_vertices; vertex++) {
+        if (image[vertex] == vertex) continue;
+        if (image[vertex ^ 1] != (image[vertex] ^ 1)) return false;
+        for (uint32_t i = edge_starts[vertex]; i < edge_starts[vertex + 1]; i++) {
+            if (edges[i] < literal_vertices) continue;
+            uint32_t clause = edges[i] - literal_vertices;
+            if (clause_stamps[clause] == stamp) continue;
+            clause_stamps[clause] = stamp;
+            mapped.clear();
+            for (uint32_t j = clause_starts[clause]; j < clause_starts[clause + 1]; j++) {
+                mapped.push_back(image[clause_vertices[j]]);
+            }
+            std::sort(mapped.begin(), mapped.end());
+            work += static_cast<long>(mapped.size());
+            if (!contains_clause(mapped)) return false;
+        }
+    }
+    return true;
+}
+
+bool SymmetryBreaker::contains_clause(const std::vector<uint32_t> &clause) const {
+    auto found = std::lower_bound(sorted_clauses.begin(), sorted_clauses.end(), clause,
+                                  [&](uint32_t index, const std::vector<uint32_t> &key) {
+                                      return std::lexicographical_compare(
+                                              clause_vertices.begin() + clause_starts[index],
+                                              clause_vertices.begin() + clause_starts[index + 1],
+                                              key.begin(), key.end());
+                                  });
+    if (found == sorted_clauses.end()) return false;
+    uint32_t size = clause_starts[*found + 1] - clause_starts[*found];
+    return size == clause.size() &&
+           std::equal(clause.begin(), clause.end(), clause_vertices.begin() + clause_starts[*found]);
+}
+
+uint32_t SymmetryBreaker::orbit(uint32_t vertex) {
+    while (orbits[vertex] != vertex) {
+        orbits[vertex] = orbits[orbits[vertex]];
+        vertex = orbits[vertex];
+    }
+    return vertex;
+}
+
+// Only allows assignments no greater than their image under the generator, comparing the variables it moves in
+// index order: every variable is no greater than its image as long as the ones before equal theirs. An auxiliary
+// variable is implied whenever the variables up to one equal their images. Under the comparison, a variable only
+// differs from its image when it is false and the image true.
+void SymmetryBreaker::add_breaking_clauses(const std::vector<uint32_t> &generator) {
+    Literal equal = LITERAL_NONE;
+    Literal previous = LITERAL_NONE;
+    Literal previous_image = LITERAL_NONE;
+    std::vector<Literal> clause;
+    auto add = [&](Literal first, Literal second) {
+        clause.clear();
+        if (equal != LITERAL_NONE) clause.push_back(negate(equal));
+        clause.push_back(first);
+        if (second != LITERAL_NONE) clause.push_back(second);
+        formula.add_clause(clause);
+    };
+
+    size_t compared = 0;
+    // The moved literals come in increasing order, so every variable is met through its positive literal first.
+    for (size_t i = 0; i < generator.size() && compared < LEX_LEADER_SIZE; i += 2) {
+        if (generator[i] & 1) continue;
+        Literal literal = make_literal(variables[generator[i] / 2], false);
+        Literal literal_image = make_literal(variables[generator[i + 1] / 2], generator[i + 1] & 1);
+        compared++;
+
+        if (previous != LITERAL_NONE) {
+            Var auxiliary = static_cast<Var>(formula.variables_count());
+            formula.set_variables_count(auxiliary + 1);
+            formula.auxiliary_variables_count++;
+            Literal next = make_literal(auxiliary, false);
+            add(negate(previous), next);
+            add(previous_image, next);
+            equal = next;
+        }
+        // A variable mapped onto its negation never equals its image, so it has to be false and ends the comparison.
+        if (literal_image == negate(literal)) {
+            add(negate(literal), LITERAL_NONE);
+            return;
+        }
+        add(negate(literal), literal_image);
+        previous = literal;
+        previous_image = literal_image;
+    }
+}
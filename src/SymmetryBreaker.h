@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Formula.h"
+
+// Adds lex-leader symmetry-breaking clauses to a preprocessed formula before the search starts. Symmetries are
+// automorphisms of the colored graph with a vertex per literal and per clause, where literals are joined to their
+// negation and to the clauses they occur in. Their generators come from a partition-refinement search in the style
+// of nauty and saucy: a first path individualizes vertices down to a discrete partition, and the other vertices of
+// the cell split at every level are tried in turn, following the choices of the first path below them where they
+// can. A branch that doesn't end in an automorphism is given up rather than searched, so generators may be missed,
+// but every permutation kept is checked against the clauses.
+//
+// For every generator, the clauses only allow assignments that are lexicographically no greater than their image,
+// comparing the variables it moves in index order, with auxiliary variables chaining the comparisons. They are not
+// implied by the formula, so they can't be added to a formula whose proof is logged.
+class SymmetryBreaker {
+public:
+    explicit SymmetryBreaker(Formula &formula) : formula(formula) {}
+
+    // Returns the number of generators broken.
+    size_t break_symmetries();
+
+private:
+    // Ordered partition of the vertices. Cells are ranges of `elements` and are identified by their start.
+    struct Partition {
+        std::vector<uint32_t> elements;
+        std::vector<uint32_t> positions;
+        std::vector<uint32_t> cell_of;
+        // End of every cell, indexed by its start.
+        std::vector<uint32_t> cell_ends;
+    };
+
+    Formula &formula;
+
+    // Variables of the clauses not satisfied at the top level, in index order. Their literals are the first
+    // vertices, 2 * index + polarity, so that the negation of a vertex is a single xor; clause vertices follow.
+    std::vector<Var> variables;
+    uint32_t literal_vertices = 0;
+    uint32_t vertices = 0;
+    std::vector<uint32_t> edge_starts;
+    std::vector<uint32_t> edges;
+
+    // Literal vertices of every clause, sorted, and the clauses in lexicographic order for looking them up.
+    std::vector<uint32_t> clause_starts;
+    std::vector<uint32_t> clause_vertices;
+    std::vector<uint32_t> sorted_clauses;
+
+    // Refinement state, all clear in between refinements.
+    std::vector<uint32_t> splitters;
+    std::vector<uint8_t> queued;
+    std::vector<uint32_t> hits;
+    std::vector<uint32_t> touched;
+
+    // Vertex individualized at every level of the first path, and the cell it was taken from.
+    std::vector<uint32_t> path;
+    std::vector<uint32_t> path_cells;
+    std::vector<std::vector<uint32_t>> path_candidates;
+
+    // Image of every literal vertex under the permutation being checked, and the generators found, as the literal
+    // vertices they move in increasing order, each followed by its image.
+    std::vector<uint32_t> image;
+    std::vector<uint32_t> mapped;
+    std::vector<uint32_t> clause_stamps;
+    uint32_t stamp = 0;
+    std::vector<std::vector<uint32_t>> generators;
+    // Union-find over the literal vertices, joining those the generators map onto each other.
+    std::vector<uint32_t> orbits;
+
+    long work = 0;
+
+    void build_graph();
+
+    void refine(Partition &);
+
+    void split(Partition &, uint32_t, const uint32_t *, const uint32_t *);
+
+    void individualize(Partition &, uint32_t);
+
+    uint32_t target_cell(const Partition &) const;
+
+    bool descend(Partition &, size_t);
+
+    bool automorphism(const Partition &, const Partition &);
+
+    bool contains_clause(const std::vector<uint32_t> &) const;
+
+    uint32_t orbit(uint32_t);
+
+    void add_breaking_clauses(const std::vector<uint32_t> &);
+};
@@ -0,0 +1,66 @@
+#include "VariableHeap.h"
+
+void VariableHeap::insert(Var variable) {
+    if (variable >= positions.size()) {
+        positions.resize(variable + 1, NOT_IN_HEAP);
+    }
+    if (positions[variable] != NOT_IN_HEAP) return;
+
+    positions[variable] = heap.size();
+    heap.push_back(variable);
+    sift_up(heap.size() - 1);
+}
+
+Var VariableHeap::pop() {
+    Var top_variable = heap.front();
+    positions[top_variable] = NOT_IN_HEAP;
+    heap.front() = heap.back();
+    heap.pop_back();
+    if (!heap.empty()) {
+        positions[heap.front()] = 0;
+        sift_down(0);
+    }
+    return top_variable;
+}
+
+void VariableHeap::increased(Var variable) {
+    if (contains(variable)) {
+        sift_up(positions[variable]);
+    }
+}
+
+void VariableHeap::clear() {
+    for (const Var &variable: heap) {
+        positions[variable] = NOT_IN_HEAP;
+    }
+    heap.clear();
+}
+
+void VariableHeap::sift_up(size_t position) {
+    Var variable = heap[position];
+    while (position > 0) {
+        size_t parent = (position - 1) / 2;
+        if (!before(variable, heap[parent])) break;
+        heap[position] = heap[parent];
+        positions[heap[position]] = position;
+        position = parent;
+    }
+    heap[position] = variable;
+    positions[variable] = position;
+}
+
+void VariableHeap::sift_down(size_t position) {
+    Var variable = heap[position];
+    while (2 * position + 1 < heap.size()) {
+        size_t child = 2 * position + 1;
+        if (child + 1 < heap.size() && before(heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!before(heap[child], variable)) break;
+        heap[position] = heap[child];
+        positions[heap[position]] = position;
+        position = child;
+    }
+    heap[position] = variable;
+    positions[variable] = position;
+}
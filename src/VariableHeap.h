@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Literal.h"
+
+const size_t NOT_IN_HEAP = SIZE_MAX;
+
+// Indexed binary max-heap of variables ordered by an external score vector.
+class VariableHeap {
+public:
+    explicit VariableHeap(const std::vector<double> *scores) : scores(scores) {}
+
+    bool empty() const {
+        return heap.empty();
+    }
+
+    size_t size() const {
+        return heap.size();
+    }
+
+    bool contains(Var variable) const {
+        return variable < positions.size() && positions[variable] != NOT_IN_HEAP;
+    }
+
+    Var top() const {
+        return heap.front();
+    }
+
+    void insert(Var variable);
+
+    Var pop();
+
+    // Restores the heap order after the score of the variable has increased.
+    void increased(Var variable);
+
+    void clear();
+
+private:
+    const std::vector<double> *scores;
+    std::vector<Var> heap;
+    std::vector<size_t> positions;
+
+    bool before(Var left, Var right) const {
+        return (*scores)[left] > (*scores)[right];
+    }
+
+    void sift_up(size_t position);
+
+    void sift_down(size_t position);
+};
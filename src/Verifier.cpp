@@ -1,18 +1,35 @@
+#include "ProofChecker.h"
 #include "Verifier.h"
 
-bool Verifier::verify(const std::list<Clause *> &clauses) {
-    for (const auto &clause: clauses) {
-        bool clause_satisfied = false;
-        for (const auto &literal: clause->literals) {
-            if ((literal.sign > 0 && literal.variable->value != F) ||
-                (literal.sign < 0 && literal.variable->value == F)) {
-                clause_satisfied = true;
-                break;
-            }
-        }
-        if (!clause_satisfied) {
-            return false;
+Verifier::Verifier(const std::string &path) {
+    DimacsParser::parse(path, cnf);
+}
+
+Verifier::Verifier(Cnf cnf) : cnf(std::move(cnf)) {}
+
+bool Verifier::verify_model(const std::vector<LiteralValue> &values) const {
+    // One bit per literal, set for the true ones.
+    std::vector<bool> true_literals(2 * std::max(cnf.variables_count(), values.size()));
+    for (Var variable = 0; variable < true_literals.size() / 2; variable++) {
+        bool negative = variable < values.size() && values[variable] == F;
+        true_literals[make_literal(variable, negative)] = true;
+    }
+
+    size_t begin = 0;
+    for (const size_t &end: cnf.clause_ends) {
+        bool satisfied = false;
+        for (size_t i = begin; i < end && !satisfied; i++) {
+            satisfied = cnf.literals[i] < true_literals.size() && true_literals[cnf.literals[i]];
         }
+        if (!satisfied) return false;
+        begin = end;
     }
     return true;
 }
+
+bool Verifier::verify_proof(const std::string &path, ProofFormat format) {
+    ProofChecker checker(cnf);
+    bool verified = checker.check(path, format);
+    failure = checker.failure;
+    return verified;
+}
@@ -1,8 +1,29 @@
 #pragma once
 
-#include "Formula.h"
+#include <string>
+#include <vector>
 
+#include "DimacsParser.h"
+#include "Proof.h"
+
+// Checks results against the input as it was read, independently of the solver's clauses, which preprocessing and
+// the search rewrite.
 class Verifier {
 public:
-    static bool verify(const std::list<Clause *> &clauses);
+    // Reads the input again. Throws ParseError if it can't be.
+    explicit Verifier(const std::string &path);
+
+    // Takes clauses kept while parsing, for input that can't be read twice.
+    explicit Verifier(Cnf cnf);
+
+    // Checks a model indexed by variable, in which unassigned variables count as true.
+    bool verify_model(const std::vector<LiteralValue> &values) const;
+
+    // Throws ProofError if the proof can't be read or is malformed. On failure the reason is left in `failure`.
+    bool verify_proof(const std::string &path, ProofFormat format);
+
+    std::string failure;
+
+private:
+    Cnf cnf;
 };
@@ -0,0 +1,334 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <thread>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Benchmark.h"
+
+// How often running processes are checked for their time limit, in milliseconds.
+#define POLL_INTERVAL 50
+// Differences below this many seconds are noise, not slowdowns.
+#define SLOWDOWN_MIN_TIME 0.5
+// Exit status of the solver when an allocation fails.
+#define SOLVER_MEMOUT_STATUS 3
+
+namespace {
+
+    struct Run {
+        pid_t pid;
+        int output;
+        size_t instance;
+        size_t core;
+        std::chrono::steady_clock::time_point start;
+        std::string text;
+        bool killed;
+    };
+
+    bool has_suffix(const std::string &name, const std::string &suffix) {
+        return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    std::string file_name(const std::string &path) {
+        return path.substr(path.find_last_of('/') + 1);
+    }
+
+    // Raw value of a member anywhere in a JSON line, without the quotes of a string. The keys the solver writes are
+    // unique, nested objects included.
+    bool json_value(const std::string &line, const std::string &key, std::string &value) {
+        std::string pattern = "\"" + key + "\": ";
+        size_t position = line.find(pattern);
+        if (position == std::string::npos) return false;
+        position += pattern.size();
+        size_t end;
+        if (position < line.size() && line[position] == '"') {
+            position++;
+            end = line.find('"', position);
+        } else {
+            end = line.find_first_of(",}", position);
+        }
+        if (end == std::string::npos) return false;
+        value = line.substr(position, end - position);
+        return true;
+    }
+
+    long json_number(const std::string &line, const std::string &key) {
+        std::string value;
+        return json_value(line, key, value) ? std::strtol(value.c_str(), nullptr, 10) : -1;
+    }
+
+    std::vector<size_t> available_cores() {
+        std::vector<size_t> cores;
+#ifdef __linux__
+        cpu_set_t allowed;
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+            for (size_t core = 0; core < CPU_SETSIZE; core++) {
+                if (CPU_ISSET(core, &allowed)) cores.push_back(core);
+            }
+        }
+#endif
+        if (cores.empty()) {
+            for (size_t core = 0; core < std::max(1u, std::thread::hardware_concurrency()); core++) {
+                cores.push_back(core);
+            }
+        }
+        return cores;
+    }
+
+    // Starts the solver on the instance with its output going to a pipe, pinned to the core, under the memory limit.
+    bool start(const BenchmarkOptions &options, const std::string &instance, size_t core, Run &run) {
+        int pipe_ends[2];
+        if (pipe(pipe_ends) != 0) return false;
+        pid_t pid = fork();
+        if (pid < 0) {
+            close(pipe_ends[0]);
+            close(pipe_ends[1]);
+            return false;
+        }
+        if (pid == 0) {
+            dup2(pipe_ends[1], STDOUT_FILENO);
+            close(pipe_ends[0]);
+            close(pipe_ends[1]);
+            int null = open("/dev/null", O_WRONLY);
+            if (null >= 0) dup2(null, STDERR_FILENO);
+#ifdef __linux__
+            cpu_set_t cores;
+            CPU_ZERO(&cores);
+            CPU_SET(static_cast<int>(core), &cores);
+            sched_setaffinity(0, sizeof(cores), &cores);
+#endif
+            if (options.memory_limit > 0) {
+                rlimit limit{};
+                limit.rlim_cur = limit.rlim_max = static_cast<rlim_t>(options.memory_limit) << 20;
+                setrlimit(RLIMIT_AS, &limit);
+            }
+            std::vector<char *> arguments;
+            arguments.push_back(const_cast<char *>(options.solver.c_str()));
+            for (const std::string &argument: options.solver_arguments) {
+                arguments.push_back(const_cast<char *>(argument.c_str()));
+            }
+            arguments.push_back(const_cast<char *>(instance.c_str()));
+            arguments.push_back(nullptr);
+            execv(options.solver.c_str(), arguments.data());
+            _exit(127);
+        }
+        close(pipe_ends[1]);
+        fcntl(pipe_ends[0], F_SETFL, O_NONBLOCK);
+        run.pid = pid;
+        run.output = pipe_ends[0];
+        run.core = core;
+        run.start = std::chrono::steady_clock::now();
+        run.text.clear();
+        run.killed = false;
+        return true;
+    }
+
+    // Reads what is available; returns false at the end of the output.
+    bool drain(Run &run) {
+        char chunk[1 << 14];
+        while (true) {
+            ssize_t count = read(run.output, chunk, sizeof(chunk));
+            if (count > 0) {
+                run.text.append(chunk, static_cast<size_t>(count));
+            } else if (count == 0) {
+                return false;
+            } else {
+                return errno == EINTR || errno == EAGAIN;
+            }
+        }
+    }
+
+    // Fills in the result from the last JSON line of the output and the exit status.
+    void finish(const Run &run, int status, const rusage &usage, const BenchmarkOptions &options,
+                BenchmarkResult &result) {
+        result.wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - run.start).count();
+        result.cpu_time = static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+                          static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+        result.peak_rss_kb = usage.ru_maxrss;
+
+        size_t line_start = run.text.rfind("\n{");
+        std::string line = run.text.substr(line_start == std::string::npos ? 0 : line_start + 1);
+        std::string answer;
+        if (!run.killed && WIFEXITED(status) && WEXITSTATUS(status) == 0 && json_value(line, "Result", answer)) {
+            result.result = answer;
+            result.conflicts = json_number(line, "Conflicts");
+            result.decisions = json_number(line, "Decisions");
+            result.propagations = json_number(line, "Propagations");
+        } else if (run.killed) {
+            result.result = "TIMEOUT";
+        } else if ((WIFEXITED(status) && WEXITSTATUS(status) == SOLVER_MEMOUT_STATUS) ||
+                   (WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL)) {
+            // The solver exits with a status of its own when an allocation fails, and only the kernel kills it
+            // otherwise. Other signals are crashes.
+            result.result = "MEMOUT";
+        } else {
+            result.result = "ERROR";
+        }
+        // Killed runs are charged the full limit.
+        if (run.killed) result.wall_time = std::max(result.wall_time, options.timeout);
+    }
+}
+
+std::vector<BenchmarkResult> Benchmark::run(const std::vector<std::string> &instances) const {
+    std::vector<BenchmarkResult> results(instances.size());
+    std::vector<Run> running;
+    // Jobs beyond the number of cores we may run on share them.
+    std::vector<size_t> cores = available_cores();
+    std::vector<size_t> free_cores;
+    for (size_t job = options.jobs; job > 0; job--) {
+        free_cores.push_back(cores[(job - 1) % cores.size()]);
+    }
+
+    size_t next = 0;
+    while (next < instances.size() || !running.empty()) {
+        while (next < instances.size() && running.size() < options.jobs) {
+            Run run{};
+            results[next].instance = file_name(instances[next]);
+            if (!start(options, instances[next], free_cores.back(), run)) {
+                results[next++].result = "ERROR";
+                continue;
+            }
+            run.instance = next++;
+            free_cores.pop_back();
+            running.push_back(run);
+        }
+
+        std::vector<pollfd> outputs;
+        for (const Run &run: running) {
+            if (run.output >= 0) outputs.push_back({run.output, POLLIN, 0});
+        }
+        poll(outputs.data(), outputs.size(), POLL_INTERVAL);
+
+        auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < running.size();) {
+            Run &run = running[i];
+            if (run.output >= 0 && !drain(run)) {
+                close(run.output);
+                run.output = -1;
+            }
+            if (!run.killed && std::chrono::duration<double>(now - run.start).count() > options.timeout) {
+                kill(run.pid, SIGKILL);
+                run.killed = true;
+            }
+
+            int status;
+            rusage usage{};
+            if (wait4(run.pid, &status, WNOHANG, &usage) != run.pid) {
+                i++;
+                continue;
+            }
+            if (run.output >= 0) {
+                drain(run);
+                close(run.output);
+            }
+            finish(run, status, usage, options, results[run.instance]);
+            free_cores.push_back(run.core);
+            running[i] = running.back();
+            running.pop_back();
+        }
+    }
+    return results;
+}
+
+std::vector<std::string> Benchmark::list_instances(const std::string &directory) {
+    std::vector<std::string> instances;
+    DIR *entries = opendir(directory.c_str());
+    if (entries == nullptr) return instances;
+    while (dirent *entry = readdir(entries)) {
+        std::string name = entry->d_name;
+        if (!has_suffix(name, ".cnf") && !has_suffix(name, ".cnf.gz") && !has_suffix(name, ".cnf.xz")) continue;
+        std::string path = directory + (has_suffix(directory, "/") ? "" : "/") + name;
+        struct stat status{};
+        if (stat(path.c_str(), &status) == 0 && S_ISREG(status.st_mode)) instances.push_back(path);
+    }
+    closedir(entries);
+    std::sort(instances.begin(), instances.end());
+    return instances;
+}
+
+void Benchmark::write_result(std::ostream &output, const BenchmarkResult &result) {
+    output << std::fixed << std::setprecision(2) <<
+           R"({"Instance": ")" << result.instance << "\", " <<
+           R"("Time": ")" << result.wall_time << "\", " <<
+           R"("Result": ")" << result.result << "\", " <<
+           R"("CpuTime": )" << result.cpu_time << ", " <<
+           R"("PeakRSS": )" << result.peak_rss_kb << ", " <<
+           R"("Conflicts": )" << result.conflicts << ", " <<
+           R"("Decisions": )" << result.decisions << ", " <<
+           R"("Propagations": )" << result.propagations << "}" << std::endl;
+}
+
+std::vector<BenchmarkResult> Benchmark::read_results(const std::string &path) {
+    std::vector<BenchmarkResult> results;
+    std::ifstream input(path);
+    std::string line;
+    while (std::getline(input, line)) {
+        BenchmarkResult result;
+        std::string time;
+        if (!json_value(line, "Instance", result.instance) || !json_value(line, "Result", result.result)) continue;
+        if (result.result == "--") result.result = "ERROR";
+        if (json_value(line, "Time", time)) result.wall_time = std::strtod(time.c_str(), nullptr);
+        results.push_back(result);
+    }
+    return results;
+}
+
+double Benchmark::par2(const std::vector<BenchmarkResult> &results, double timeout) {
+    if (results.empty()) return 0;
+    double total = 0;
+    for (const BenchmarkResult &result: results) {
+        total += result.solved() ? result.wall_time : 2 * timeout;
+    }
+    return total / static_cast<double>(results.size());
+}
+
+size_t Benchmark::compare(const std::vector<BenchmarkResult> &results, const std::vector<BenchmarkResult> &baseline,
+                          double timeout, double slowdown, std::ostream &output) {
+    std::map<std::string, const BenchmarkResult *> baseline_results;
+    for (const BenchmarkResult &result: baseline) {
+        baseline_results[result.instance] = &result;
+    }
+
+    size_t failures = 0;
+    std::vector<BenchmarkResult> compared;
+    std::vector<BenchmarkResult> compared_baseline;
+    output << std::fixed << std::setprecision(2);
+    for (const BenchmarkResult &result: results) {
+        auto found = baseline_results.find(result.instance);
+        if (found == baseline_results.end()) continue;
+        const BenchmarkResult &before = *found->second;
+        compared.push_back(result);
+        compared_baseline.push_back(before);
+
+        if (result.solved() && before.solved() && result.result != before.result) {
+            output << "WRONG " << result.instance << ": " << result.result << ", baseline " << before.result << "\n";
+            failures++;
+        } else if (result.result == "ERROR" && before.solved()) {
+            output << "CRASHED " << result.instance << ", baseline " << before.result << "\n";
+            failures++;
+        } else if (!result.solved() && before.solved()) {
+            output << "UNSOLVED " << result.instance << ": " << result.result << ", baseline " << before.wall_time
+                   << "s\n";
+        } else if (result.solved() && before.solved() && result.wall_time > slowdown * before.wall_time &&
+                   result.wall_time - before.wall_time > SLOWDOWN_MIN_TIME) {
+            output << "SLOWER " << result.instance << ": " << result.wall_time << "s, baseline " << before.wall_time
+                   << "s\n";
+        }
+    }
+    output << "Compared " << compared.size() << " instances, PAR-2 " << par2(compared, timeout) << ", baseline "
+           << par2(compared_baseline, timeout) << std::endl;
+    return failures;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Outcome of one solver run. Runs without an answer are TIMEOUT, MEMOUT or ERROR; counters the solver didn't
+// report are -1.
+struct BenchmarkResult {
+    std::string instance;
+    std::string result;
+    double wall_time = 0;
+    double cpu_time = 0;
+    long peak_rss_kb = 0;
+    long conflicts = -1;
+    long decisions = -1;
+    long propagations = -1;
+
+    bool solved() const {
+        return result == "SAT" || result == "UNSAT";
+    }
+};
+
+struct BenchmarkOptions {
+    std::string solver;
+    std::vector<std::string> solver_arguments;
+    size_t jobs = 1;
+    // Wall time in seconds, and address space in MiB, 0 for none.
+    double timeout = 60;
+    size_t memory_limit = 0;
+};
+
+// Runs the solver on many instances at once, one process per job, each pinned to a core of its own. Runs are
+// killed when they exceed the time limit; the memory limit caps their address space. The results are read from
+// the JSON line the solver prints last, and the times and peak memory from the resource usage of the process.
+class Benchmark {
+public:
+    explicit Benchmark(BenchmarkOptions options) : options(std::move(options)) {}
+
+    // Results in the order of the instances.
+    std::vector<BenchmarkResult> run(const std::vector<std::string> &instances) const;
+
+    // Files in the directory that look like CNF, compressed ones included, sorted by name.
+    static std::vector<std::string> list_instances(const std::string &directory);
+
+    // Writes a result as a JSON line in the format of the solver, which read_results() reads back.
+    static void write_result(std::ostream &output, const BenchmarkResult &result);
+
+    // Reads results written by write_result() or logged by runAll.sh, where unsolved runs have "--" as their time.
+    static std::vector<BenchmarkResult> read_results(const std::string &path);
+
+    // Average time with unsolved runs counted as twice the time limit.
+    static double par2(const std::vector<BenchmarkResult> &results, double timeout);
+
+    // Prints the results missing or slower by the given factor compared to the baseline, the wrong answers and the
+    // crashes on instances the baseline solved. Returns the number of wrong answers and crashes.
+    static size_t compare(const std::vector<BenchmarkResult> &results, const std::vector<BenchmarkResult> &baseline,
+                          double timeout, double slowdown, std::ostream &output);
+
+private:
+    BenchmarkOptions options;
+};
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "Benchmark.h"
+
+// A run counts as slower than the baseline when it takes this many times as long.
+#define DEFAULT_SLOWDOWN 1.5
+
+int main(int argc, char **argv) {
+    BenchmarkOptions options;
+    std::string argv0 = argv[0];
+    options.solver = argv0.substr(0, argv0.find_last_of('/') + 1) + "sat-solver";
+    options.jobs = std::max(1u, std::thread::hardware_concurrency());
+    std::string directory;
+    std::string output_path;
+    std::string baseline_path;
+    double slowdown = DEFAULT_SLOWDOWN;
+    bool usage_error = false;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--solver" && i + 1 < argc) {
+            options.solver = argv[++i];
+        } else if (argument == "--jobs" && i + 1 < argc) {
+            long jobs = std::strtol(argv[++i], nullptr, 10);
+            usage_error = usage_error || jobs < 1;
+            options.jobs = static_cast<size_t>(std::max(1L, jobs));
+        } else if (argument == "--timeout" && i + 1 < argc) {
+            options.timeout = std::strtod(argv[++i], nullptr);
+            usage_error = usage_error || options.timeout <= 0;
+        } else if (argument == "--memory" && i + 1 < argc) {
+            options.memory_limit = std::strtoul(argv[++i], nullptr, 10);
+        } else if (argument == "--output" && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (argument == "--baseline" && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (argument == "--slowdown" && i + 1 < argc) {
+            slowdown = std::strtod(argv[++i], nullptr);
+        } else if (argument == "--") {
+            // Everything after is passed on to the solver.
+            options.solver_arguments.assign(argv + i + 1, argv + argc);
+            break;
+        } else if (directory.empty()) {
+            directory = argument;
+        } else {
+            usage_error = true;
+        }
+    }
+    if (usage_error || directory.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--solver PATH] [--jobs N] [--timeout SECONDS] [--memory MIB]"
+                  << " [--output FILE] [--baseline FILE] [--slowdown FACTOR] <directory> [-- solver arguments]"
+                  << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> instances = Benchmark::list_instances(directory);
+    if (instances.empty()) {
+        std::cerr << "No instances in " << directory << std::endl;
+        return 1;
+    }
+    std::vector<BenchmarkResult> results = Benchmark(options).run(instances);
+
+    std::ofstream output_file;
+    if (!output_path.empty()) {
+        output_file.open(output_path);
+        if (!output_file) {
+            std::cerr << "Cannot create " << output_path << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &output = output_path.empty() ? std::cout : output_file;
+    size_t sat = 0;
+    size_t unsat = 0;
+    for (const BenchmarkResult &result: results) {
+        Benchmark::write_result(output, result);
+        sat += result.result == "SAT";
+        unsat += result.result == "UNSAT";
+    }
+    std::cerr << std::fixed << std::setprecision(2) << "Solved " << sat + unsat << " of " << results.size()
+              << " (" << sat << " SAT, " << unsat << " UNSAT), PAR-2 " << Benchmark::par2(results, options.timeout)
+              << std::endl;
+
+    if (baseline_path.empty()) return 0;
+    std::vector<BenchmarkResult> baseline = Benchmark::read_results(baseline_path);
+    if (baseline.empty()) {
+        std::cerr << "No results in " << baseline_path << std::endl;
+        return 1;
+    }
+    // Wrong answers and crashes fail the run.
+    return Benchmark::compare(results, baseline, options.timeout, slowdown, std::cerr) > 0 ? 2 : 0;
+}
@@ -1,85 +1,295 @@
 #include <algorithm>
-#include <cassert>
+#include <atomic>
 #include <chrono>
-#include <fstream>
+#include <climits>
+#include <csignal>
+#include <cstdlib>
 #include <iostream>
-#include <iomanip>
+#include <new>
 
+#include <unistd.h>
+
+#include "CubeAndConquer.h"
+#include "DimacsParser.h"
 #include "Formula.h"
+#include "LocalSearch.h"
+#include "Portfolio.h"
+#include "Preprocessor.h"
+#include "Proof.h"
+#include "Report.h"
+#include "Server.h"
+#include "SymmetryBreaker.h"
 #include "Verifier.h"
 #include "strategies/branching/VSIDSStrategy.h"
-#include "strategies/branching/JeroslowWangStrategy.h"
+#include "strategies/restart/RestartStrategy.h"
 
+// Builds can leave out checking models against the input, which reads it a second time.
+#ifndef VERIFY
 #define VERIFY true
+#endif
+#define PREPROCESS true
+// Exit status when an allocation fails, which sat-bench reports as a memory out rather than a crash.
+#define MEMOUT_STATUS 3
 
-int main(int argc, char **argv) {
-    std::ifstream file(argv[1]);
+namespace {
 
-    Formula formula;
+    // Set on SIGINT or SIGTERM, which stops the search with the best answer so far.
+    std::atomic<bool> interrupted(false);
 
-    std::string line;
-    while (std::getline(file, line)) {
-        if (line[0] == 'c') {
-            continue;
-        } else if (line[0] == 'p') {
-            std::vector<std::string> params = split(line, ' ');
+    void interrupt(int) {
+        interrupted.store(true);
+    }
 
-            assert(params.size() == 4);
-            formula.set_variables_count(std::stol(params[2]));
-            formula.set_clauses_count(std::stol(params[3]));
+    // Ends the solver from whichever thread fails to allocate, without allocating itself.
+    void out_of_memory() {
+        static const char message[] = "out of memory\n";
+        ssize_t written = write(STDERR_FILENO, message, sizeof(message) - 1);
+        (void) written;
+        _exit(MEMOUT_STATUS);
+    }
+}
 
-            while (std::getline(file, line)) {
-                formula.add_clause(line);
+int main(int argc, char **argv) {
+    std::string path;
+    long threads = 1;
+    long cube_depth = 0;
+    RestartPolicy restart_policy = RESTART_ALTERNATING;
+    bool local_search = false;
+    std::string proof_path;
+    ProofFormat proof_format = PROOF_DRAT;
+    bool check_proof = false;
+    bool break_symmetries = true;
+    bool server = false;
+    ServerOptions server_options;
+    SearchLimits limits;
+    double timeout = 0;
+    bool usage_error = false;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--threads" && i + 1 < argc) {
+            threads = std::strtol(argv[++i], nullptr, 10);
+        } else if (argument == "--cube-depth" && i + 1 < argc) {
+            cube_depth = std::strtol(argv[++i], nullptr, 10);
+        } else if (argument == "--restarts" && i + 1 < argc) {
+            std::string policy = argv[++i];
+            if (policy == "luby") {
+                restart_policy = RESTART_LUBY;
+            } else if (policy == "glucose") {
+                restart_policy = RESTART_GLUCOSE;
+            } else if (policy == "alternating") {
+                restart_policy = RESTART_ALTERNATING;
+            } else {
+                usage_error = true;
             }
+        } else if (argument == "--mode" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            local_search = mode == "sls";
+            usage_error = usage_error || (mode != "sls" && mode != "cdcl");
+        } else if (argument == "--proof" && i + 1 < argc) {
+            proof_path = argv[++i];
+        } else if (argument == "--proof-format" && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format == "drat") {
+                proof_format = PROOF_DRAT;
+            } else if (format == "drat-text") {
+                proof_format = PROOF_DRAT_TEXT;
+            } else if (format == "lrat") {
+                proof_format = PROOF_LRAT;
+            } else if (format == "lrat-text") {
+                proof_format = PROOF_LRAT_TEXT;
+            } else {
+                usage_error = true;
+            }
+        } else if (argument == "--check") {
+            check_proof = true;
+        } else if (argument == "--no-symmetry") {
+            break_symmetries = false;
+        } else if (argument == "--server") {
+            server = true;
+        } else if (argument == "--socket" && i + 1 < argc) {
+            server_options.socket_path = argv[++i];
+        } else if (argument == "--timeout" && i + 1 < argc) {
+            timeout = std::strtod(argv[++i], nullptr);
+            usage_error = usage_error || timeout < 0;
+        } else if (argument == "--conflicts" && i + 1 < argc) {
+            limits.conflicts = std::strtol(argv[++i], nullptr, 10);
+            usage_error = usage_error || limits.conflicts < 0;
+        } else if (argument == "--propagations" && i + 1 < argc) {
+            limits.propagations = std::strtol(argv[++i], nullptr, 10);
+            usage_error = usage_error || limits.propagations < 0;
+        } else if (argument == "--decisions" && i + 1 < argc) {
+            limits.decisions = std::strtol(argv[++i], nullptr, 10);
+            usage_error = usage_error || limits.decisions < 0;
+        } else if (argument == "--memory" && i + 1 < argc) {
+            limits.memory = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10)) << 20;
+        } else if (path.empty()) {
+            path = argument;
+        } else {
+            path.clear();
             break;
         }
     }
+    // The server only takes the options it passes on to its jobs.
+    usage_error = usage_error || (server && (local_search || cube_depth > 0 || !proof_path.empty() || check_proof));
+    if (usage_error || path.empty() == !server || threads < 1 || cube_depth < 0) {
+        std::cerr << "Usage: " << argv[0] << " [--mode cdcl|sls] [--threads N] [--cube-depth D]"
+                  << " [--restarts luby|glucose|alternating] [--proof FILE]"
+                  << " [--proof-format drat|drat-text|lrat|lrat-text] [--check] [--timeout SECONDS] [--conflicts N]"
+                  << " [--propagations N] [--decisions N] [--memory MIB] [--no-symmetry] <input.cnf[.gz|.xz] | ->"
+                  << std::endl;
+        std::cerr << "       " << argv[0] << " --server [--socket PATH] [--threads N] [--timeout SECONDS]"
+                  << " [--restarts luby|glucose|alternating] [--conflicts N] [--propagations N] [--decisions N]"
+                  << " [--memory MIB] [--no-symmetry]" << std::endl;
+        return 1;
+    }
+    // Jobs are solved one per thread.
+    if (server) {
+        server_options.workers = static_cast<size_t>(threads);
+        server_options.timeout = timeout;
+        server_options.limits = limits;
+        server_options.break_symmetries = break_symmetries;
+        server_options.restart_policy = restart_policy;
+        return Server(server_options).serve() ? 0 : 1;
+    }
+    // The server answers jobs that run out of memory with an error instead.
+    std::set_new_handler(out_of_memory);
+    if (!PROOFS && !proof_path.empty()) {
+        std::cerr << "This build doesn't produce proofs" << std::endl;
+        return 1;
+    }
+    // The proof is checked against the input read again.
+    if (check_proof && (proof_path.empty() || path == "-")) {
+        std::cerr << "--check needs --proof and an input file" << std::endl;
+        return 1;
+    }
+    // Refuted cubes are not logged, and LRAT hints only come from the search of a single solver.
+    bool lrat = proof_format == PROOF_LRAT || proof_format == PROOF_LRAT_TEXT;
+    if (!proof_path.empty() && (cube_depth > 0 || (lrat && threads > 1))) {
+        std::cerr << "Proofs can't be produced with --cube-depth, nor LRAT proofs with --threads" << std::endl;
+        return 1;
+    }
 
-    const BranchingStrategy &strategy = VSIDSStrategy();
+    // The time limit covers parsing and preprocessing too, but only the search stops at it.
+    if (timeout > 0) {
+        limits.deadline = std::chrono::steady_clock::now() +
+                          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                  std::chrono::duration<double>(timeout));
+    }
+    std::signal(SIGINT, interrupt);
+    std::signal(SIGTERM, interrupt);
 
-    auto start = std::chrono::high_resolution_clock::now();
-    bool sat = formula.solve(strategy);
-    auto stop = std::chrono::high_resolution_clock::now();
+    Formula formula;
+    formula.limits = limits;
+    formula.interrupt = &interrupted;
 
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    // LRAT clause ids follow the order of the input clauses.
+    std::unique_ptr<Proof> proof;
+    if (!proof_path.empty()) {
+        try {
+            proof.reset(new Proof(proof_path, proof_format));
+        } catch (const ProofError &error) {
+            std::cerr << error.what() << std::endl;
+            return 1;
+        }
+        formula.proof = proof.get();
+    }
 
-    std::string path = argv[1];
+    // Results are checked against the input read again, or against the clauses as they were read when it can't be.
+    std::unique_ptr<Verifier> verifier;
+    auto parse_start = std::chrono::high_resolution_clock::now();
+    try {
+        if (VERIFY && path == "-") {
+            Cnf cnf;
+            DimacsParser::parse(path, formula, cnf);
+            verifier.reset(new Verifier(std::move(cnf)));
+        } else {
+            DimacsParser::parse(path, formula);
+        }
+    } catch (const ParseError &error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
 
-    std::cout << std::boolalpha;
+    VSIDSStrategy strategy;
+    std::unique_ptr<RestartStrategy> restarts = make_restart_strategy(restart_policy, LUBY_UNIT);
 
-    if (VERIFY && sat) {
-        assert(Verifier::verify(formula.clauses));
+    auto start = std::chrono::high_resolution_clock::now();
+    // Preprocessing doesn't produce LRAT hints.
+    if (PREPROCESS && (proof == nullptr || !lrat)) {
+        Preprocessor(formula).preprocess();
     }
+    // Symmetry-breaking clauses don't follow from the formula, so they can't be part of a proof.
+    if (break_symmetries && proof == nullptr) {
+        SymmetryBreaker(formula).break_symmetries();
+    }
+    auto search_start = std::chrono::high_resolution_clock::now();
+    bool sat;
+    if (local_search) {
+        // Local search can't tell an unsatisfiable formula apart, it keeps flipping unless preprocessing refutes it.
+        LocalSearch walker(formula, SEED);
+        walker.interrupt = &interrupted;
+        walker.deadline = limits.deadline;
+        sat = !formula.empty_clause && walker.walk(formula.saved_phases, LONG_MAX);
+        formula.values = walker.best_phases();
+        formula.extend_model();
+        if (!sat && !formula.empty_clause) {
+            formula.stopped = true;
+            formula.best_phases = walker.best_phases();
+        }
+    } else if (cube_depth > 0) {
+        CubeAndConquer cube_and_conquer(static_cast<size_t>(threads), static_cast<size_t>(cube_depth), restart_policy);
+        sat = cube_and_conquer.solve(formula);
+    } else if (threads > 1) {
+        sat = Portfolio(static_cast<size_t>(threads), restart_policy).solve(formula);
+    } else {
+        sat = formula.solve(strategy, *restarts);
+    }
+    if (proof != nullptr) {
+        proof->close();
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
 
-    std::cout << R"({"Instance": ")" << path.substr(path.find_last_of("/\\") + 1) << "\", " <<
-              R"("Time": ")" << std::fixed << std::setprecision(2) << (float) duration.count() / 1000 << "\", " <<
-              R"("Result": ")" << (sat ? "SAT" : "UNSAT") << "\"";
-
-    if (sat) {
-        std::cout << ", " << R"("Solution": ")";
-        formula.variables.sort([](const auto &a, const auto &b) {
-            return a->id < b->id;
-        });
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
+    typedef std::chrono::duration<double> seconds;
+    double parse_time = std::chrono::duration_cast<seconds>(start - parse_start).count();
+    double preprocess_time = std::chrono::duration_cast<seconds>(search_start - start).count();
+    double search_time = std::chrono::duration_cast<seconds>(stop - search_start).count();
 
-        std::string solution;
-        for (auto &variable: formula.variables) {
-            const auto &id = variable->id;
-            const auto &value = variable->value;
+    std::cout << std::boolalpha;
 
-            solution.append(std::to_string(id));
-            solution.append(" ");
-            if (value != U) {
-                solution.append(value == T ? "true" : "false");
-            } else {
-                solution.append("true");
-            }
-            solution.append(" ");
+    if ((VERIFY || check_proof) && verifier == nullptr) {
+        try {
+            verifier.reset(new Verifier(path));
+        } catch (const ParseError &error) {
+            std::cerr << error.what() << std::endl;
+            return 1;
         }
-        solution.pop_back();
-        std::cout << solution << "\"}" << std::endl;
-    } else {
-        std::cout << "}" << std::endl;
     }
+    if (VERIFY && sat && !verifier->verify_model(formula.values)) {
+        std::cerr << "The model doesn't satisfy the input" << std::endl;
+        return 1;
+    }
+    std::string proof_status;
+    // A stopped search has neither a model nor a complete proof.
+    if (check_proof && formula.empty_clause) {
+        try {
+            proof_status = verifier->verify_proof(proof_path, proof_format) ? "VERIFIED" : "REJECTED";
+        } catch (const ProofError &error) {
+            verifier->failure = error.what();
+            proof_status = "REJECTED";
+        }
+        if (!verifier->failure.empty()) std::cerr << verifier->failure << std::endl;
+    }
+
+    Report report;
+    report.instance = path.substr(path.find_last_of("/\\") + 1);
+    report.result = sat ? "SAT" : formula.empty_clause ? "UNSAT" : "UNKNOWN";
+    report.proof_status = proof_status;
+    report.time = static_cast<double>(duration.count()) / 1000;
+    report.parse_time = parse_time;
+    report.preprocess_time = preprocess_time;
+    report.search_time = search_time;
+    write_report(std::cout, report, formula);
 
     return 0;
 }
@@ -4,5 +4,28 @@
 
 class BranchingStrategy {
 public:
-    virtual std::pair<Variable *, LiteralValue> choose(const Formula &initial) const = 0;
+    virtual ~BranchingStrategy() = default;
+
+    // Called once before the search starts.
+    virtual void initialize(const Formula &) {}
+
+    // Called before a later search if variables were added to the formula since the previous one.
+    virtual void variables_added(const Formula &) {}
+
+    // Returns LITERAL_NONE once every variable is assigned.
+    virtual Literal choose(const Formula &formula) = 0;
+
+    // Called for every literal of a learned clause.
+    virtual void bump(Literal) {}
+
+    // Called once per conflict, after the learned clause has been bumped.
+    virtual void decay() {}
+
+    // Called whenever a variable is unassigned on backtrack.
+    virtual void unassigned(Var) {}
+
+    // Level a restart backtracks to. Decisions below it would be picked again right away, so they are kept.
+    virtual uint32_t restart_level(const Formula &) {
+        return 0;
+    }
 };
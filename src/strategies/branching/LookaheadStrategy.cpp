@@ -0,0 +1,96 @@
+#include "LookaheadStrategy.h"
+
+void LookaheadStrategy::initialize(const Formula &formula) {
+    values.assign(formula.variables_count(), U);
+}
+
+Literal LookaheadStrategy::choose(const Formula &formula) {
+    // Preselect the free variables with the most occurrences in both polarities.
+    candidates.clear();
+    for (Var variable = 0; variable < formula.variables_count(); variable++) {
+        if (formula.values[variable] == U && !formula.eliminated[variable]) {
+            candidates.push_back(variable);
+        }
+    }
+    auto weight = [&](Var variable) {
+        return (formula.occurrences[make_literal(variable, false)].size() + 1) *
+               (formula.occurrences[make_literal(variable, true)].size() + 1);
+    };
+    if (candidates.size() > max_candidates) {
+        std::partial_sort(candidates.begin(), candidates.begin() + static_cast<long>(max_candidates), candidates.end(),
+                          [&](const Var &left, const Var &right) {
+                              return weight(left) > weight(right);
+                          });
+        candidates.resize(max_candidates);
+    }
+    if (candidates.empty()) return LITERAL_NONE;
+
+    values = formula.values;
+    Literal best = LITERAL_NONE;
+    size_t best_score = 0;
+    for (const Var &variable: candidates) {
+        Literal positive = make_literal(variable, false);
+        Literal negative = make_literal(variable, true);
+        bool positive_conflict, negative_conflict;
+        size_t positive_implied = look(formula, positive, positive_conflict);
+        size_t negative_implied = look(formula, negative, negative_conflict);
+
+        // A failed polarity forces the other one; if both fail, either decision leads to the conflict.
+        if (positive_conflict) return negative;
+        if (negative_conflict) return positive;
+
+        // The product favours variables reducing the formula in both branches.
+        size_t score = 1024 * positive_implied * negative_implied + positive_implied + negative_implied;
+        if (best == LITERAL_NONE || score > best_score) {
+            best_score = score;
+            best = positive_implied >= negative_implied ? positive : negative;
+        }
+    }
+    return best;
+}
+
+LiteralValue LookaheadStrategy::value(Literal literal) const {
+    LiteralValue variable_value = values[var_of(literal)];
+    if (variable_value == U) return U;
+    return (variable_value == T) != is_negative(literal) ? T : F;
+}
+
+// Propagates the literal through the occurrence lists and undoes it again. Returns the number of assigned literals.
+size_t LookaheadStrategy::look(const Formula &formula, Literal literal, bool &conflict) {
+    conflict = false;
+    implied.clear();
+    implied.push_back(literal);
+    values[var_of(literal)] = is_negative(literal) ? F : T;
+
+    for (size_t i = 0; i < implied.size() && !conflict; i++) {
+        for (const ClauseRef &ref: formula.occurrences[negate(implied[i])]) {
+            const Clause &clause = formula.arena[ref];
+            Literal unassigned = LITERAL_NONE;
+            size_t unassigned_count = 0;
+            bool satisfied = false;
+            for (const Literal &clause_literal: clause) {
+                LiteralValue literal_value = value(clause_literal);
+                if (literal_value == T) {
+                    satisfied = true;
+                    break;
+                }
+                if (literal_value == U) {
+                    unassigned = clause_literal;
+                    if (++unassigned_count > 1) break;
+                }
+            }
+            if (satisfied || unassigned_count > 1) continue;
+            if (unassigned_count == 0) {
+                conflict = true;
+                break;
+            }
+            values[var_of(unassigned)] = is_negative(unassigned) ? F : T;
+            implied.push_back(unassigned);
+        }
+    }
+
+    for (const Literal &implied_literal: implied) {
+        values[var_of(implied_literal)] = U;
+    }
+    return implied.size();
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+#include "strategies/branching/BranchingStrategy.h"
+
+// Branches on the variable whose two polarities imply the most assignments, measured by propagating each of them
+// over the original clauses of the formula. A polarity that leads to a conflict makes the other one forced.
+// Far too slow for every decision of the search, but a good splitting heuristic for cubing.
+class LookaheadStrategy : public BranchingStrategy {
+public:
+    explicit LookaheadStrategy(size_t max_candidates = 64) : max_candidates(max_candidates) {}
+
+    void initialize(const Formula &formula) override;
+
+    Literal choose(const Formula &formula) override;
+
+private:
+    // Number of variables looked ahead on per decision, preselected by their number of occurrences.
+    size_t max_candidates;
+
+    // Copy of the formula assignment extended by the literal looked ahead on.
+    std::vector<LiteralValue> values;
+    std::vector<Literal> implied;
+    std::vector<Var> candidates;
+
+    LiteralValue value(Literal literal) const;
+
+    size_t look(const Formula &formula, Literal literal, bool &conflict);
+};
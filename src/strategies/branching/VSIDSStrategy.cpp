@@ -1,52 +1,119 @@
-#include <random>
-
 #include "VSIDSStrategy.h"
 
-#define SEED 2951
-
-std::pair<Variable *, LiteralValue> VSIDSStrategy::choose(const Formula &formula) const {
-    std::mt19937 mt(SEED);
-
-    double conflicts_max = 0;
-    std::vector<std::pair<Variable *, LiteralValue>> target_variables = {};
-
-    for (const auto &variable: formula.variables) {
-        if (variable->value == U) {
-            if (variable->positive_conflicts + variable->negative_conflicts > conflicts_max) {
-                conflicts_max = variable->positive_conflicts + variable->negative_conflicts;
-                target_variables = {{variable,
-                                     variable->positive_conflicts > variable->negative_conflicts ? F : T}};
-            } else if (variable->positive_conflicts + variable->negative_conflicts == conflicts_max &&
-                       conflicts_max != 0) {
-                target_variables.emplace_back(variable,
-                                              variable->positive_conflicts > variable->negative_conflicts ? F : T);
-            }
+#define RESCALE_LIMIT 1e100
+
+VSIDSStrategy::VSIDSStrategy(double decay_factor, unsigned seed, InitialPhase initial_phase)
+        : decay_factor(decay_factor), initial_phase(initial_phase), heap(&activity), mt(seed) {}
+
+void VSIDSStrategy::initialize(const Formula &formula) {
+    size_t variables_count = formula.variables_count();
+    activity.assign(variables_count, 0);
+    literal_activity.assign(2 * variables_count, 0);
+    increment = 1;
+
+    size_t max_occurrences = 0;
+    for (const auto &literal_occurrences: formula.occurrences) {
+        max_occurrences = std::max(max_occurrences, literal_occurrences.size());
+    }
+
+    // Before the first conflict, prefer the variables and polarities occurring in the most clauses. The scores
+    // stay below a single bump, and ties are broken randomly.
+    std::uniform_real_distribution<double> jitter(0, 1);
+    double scale = 1.0 / (2 * max_occurrences + 2);
+    heap.clear();
+    for (Var variable = 0; variable < variables_count; variable++) {
+        Literal positive = make_literal(variable, false);
+        Literal negative = make_literal(variable, true);
+        literal_activity[positive] = scale * static_cast<double>(formula.occurrences[positive].size());
+        literal_activity[negative] = scale * static_cast<double>(formula.occurrences[negative].size());
+        activity[variable] = literal_activity[positive] + literal_activity[negative] + scale * jitter(mt);
+        if (formula.values[variable] == U && !formula.eliminated[variable]) {
+            heap.insert(variable);
         }
     }
+}
 
-    if (conflicts_max == 0) {
-        long max_positive_occurrences = 0;
-        long max_negative_occurrences = 0;
-        Variable *max_variable = nullptr;
-        for (const auto &variable: formula.variables) {
-            if (variable->value == U) {
-                if (variable->positive_occurrences.size() + variable->negative_occurrences.size() >=
-                    max_positive_occurrences + max_negative_occurrences) {
-                    max_positive_occurrences = static_cast<long>(variable->positive_occurrences.size());
-                    max_negative_occurrences = static_cast<long>(variable->negative_occurrences.size());
-                    max_variable = variable;
-                }
-            }
+void VSIDSStrategy::variables_added(const Formula &formula) {
+    auto first_new = static_cast<Var>(activity.size());
+    activity.resize(formula.variables_count(), 0);
+    literal_activity.resize(2 * formula.variables_count(), 0);
+    for (Var variable = first_new; variable < formula.variables_count(); variable++) {
+        if (formula.values[variable] == U && !formula.eliminated[variable]) {
+            heap.insert(variable);
         }
-        assert(max_variable != nullptr);
-        assert(max_variable->value == U);
-        return {max_variable, max_positive_occurrences > max_negative_occurrences ? T : F};
     }
+}
+
+Literal VSIDSStrategy::choose(const Formula &formula) {
+    // Assigned variables, and those eliminated by inprocessing, are removed lazily.
+    Var variable = VAR_NONE;
+    while (variable == VAR_NONE) {
+        if (heap.empty()) return LITERAL_NONE;
+        variable = heap.pop();
+        if (formula.values[variable] != U || formula.eliminated[variable]) variable = VAR_NONE;
+    }
+
+    // Reuse the polarity the variable had before it was unassigned, or its target phase.
+    LiteralValue phase = formula.preferred_phase(variable);
+    if (phase != U) {
+        return make_literal(variable, phase == F);
+    }
+    if (initial_phase != PHASE_OCCURRENCES) {
+        return make_literal(variable, initial_phase == PHASE_NEGATIVE);
+    }
+    Literal positive = make_literal(variable, false);
+    Literal negative = make_literal(variable, true);
+    return literal_activity[negative] > literal_activity[positive] ? negative : positive;
+}
+
+void VSIDSStrategy::bump(Literal literal) {
+    Var variable = var_of(literal);
+    literal_activity[literal] += increment;
+    activity[variable] += increment;
+    heap.increased(variable);
+    if (activity[variable] > RESCALE_LIMIT) {
+        rescale();
+    }
+}
+
+void VSIDSStrategy::decay() {
+    increment /= decay_factor;
+    if (increment > RESCALE_LIMIT) {
+        rescale();
+    }
+}
+
+void VSIDSStrategy::unassigned(Var variable) {
+    heap.insert(variable);
+}
+
+uint32_t VSIDSStrategy::restart_level(const Formula &formula) {
+    while (!heap.empty() && (formula.values[heap.top()] != U || formula.eliminated[heap.top()])) {
+        heap.pop();
+    }
+    if (heap.empty()) return formula.decision_level();
 
-    std::uniform_int_distribution<std::mt19937::result_type> dist(0, target_variables.size() - 1);
-    std::pair<Variable *, LiteralValue> target_assignment = target_variables.at(dist(mt));
+    // Keep the levels whose decisions are more active than the next decision would be.
+    double next_activity = activity[heap.top()];
+    uint32_t level = 0;
+    while (level < formula.decision_level()) {
+        size_t start = formula.trail_limits[level];
+        // Levels left empty by implied assumptions have no decision.
+        if (start == formula.trail.size()) break;
+        Var decision = var_of(formula.trail[start]);
+        if (formula.levels[decision] != level + 1 || activity[decision] < next_activity) break;
+        level++;
+    }
+    return level;
+}
 
-    assert(target_assignment.first != nullptr);
-    assert(target_assignment.first->value == U);
-    return target_assignment;
+void VSIDSStrategy::rescale() {
+    // Scaling every score by the same factor keeps the heap order intact.
+    for (auto &score: activity) {
+        score /= RESCALE_LIMIT;
+    }
+    for (auto &score: literal_activity) {
+        score /= RESCALE_LIMIT;
+    }
+    increment /= RESCALE_LIMIT;
 }
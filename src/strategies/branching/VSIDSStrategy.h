@@ -1,8 +1,53 @@
 #pragma once
 
+#include <random>
+
+#include "VariableHeap.h"
 #include "strategies/branching/BranchingStrategy.h"
 
-class VSIDSStrategy : public BranchingStrategy {
+#define SEED 2951
+
+// Polarity of a variable that has never been assigned.
+enum InitialPhase {
+    PHASE_OCCURRENCES, PHASE_POSITIVE, PHASE_NEGATIVE
+};
+
+// Exponential VSIDS: instead of decaying every score, the bump increment grows by 1 / decay_factor per conflict.
+class VSIDSStrategy final : public BranchingStrategy {
 public:
-    std::pair<Variable *, LiteralValue> choose(const Formula &formula) const override;
+    explicit VSIDSStrategy(double decay_factor = 0.95, unsigned seed = SEED,
+                           InitialPhase initial_phase = PHASE_OCCURRENCES);
+
+    VSIDSStrategy(const VSIDSStrategy &) = delete;
+
+    VSIDSStrategy &operator=(const VSIDSStrategy &) = delete;
+
+    void initialize(const Formula &formula) override;
+
+    void variables_added(const Formula &formula) override;
+
+    Literal choose(const Formula &formula) override;
+
+    void bump(Literal literal) override;
+
+    void decay() override;
+
+    void unassigned(Var variable) override;
+
+    uint32_t restart_level(const Formula &formula) override;
+
+private:
+    double decay_factor;
+    double increment = 1;
+    InitialPhase initial_phase;
+
+    // Per-variable activity deciding the branching order.
+    std::vector<double> activity;
+    // Per-literal activity deciding the polarity.
+    std::vector<double> literal_activity;
+
+    VariableHeap heap;
+    std::mt19937 mt;
+
+    void rescale();
 };
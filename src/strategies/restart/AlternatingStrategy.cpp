@@ -0,0 +1,35 @@
+#include "AlternatingStrategy.h"
+
+#define STABLE_LUBY_UNIT 1024
+#define FIRST_PHASE_LENGTH 1000
+#define PHASE_GROWTH 2
+
+AlternatingStrategy::AlternatingStrategy() : stable_luby(STABLE_LUBY_UNIT) {}
+
+void AlternatingStrategy::initialize(const Formula &formula) {
+    focused.initialize(formula);
+    stable_luby.initialize(formula);
+    stable_phase = false;
+    phase_length = FIRST_PHASE_LENGTH;
+    phase_end = formula.conflicts_count + phase_length;
+}
+
+void AlternatingStrategy::conflict(const Formula &formula, uint32_t lbd) {
+    // The averages keep following the search through stable phases.
+    focused.conflict(formula, lbd);
+}
+
+bool AlternatingStrategy::should_restart(const Formula &formula) {
+    if (formula.conflicts_count >= phase_end) {
+        // Stable phases are as long as the focused phase before them.
+        if (stable_phase) phase_length *= PHASE_GROWTH;
+        stable_phase = !stable_phase;
+        phase_end = formula.conflicts_count + phase_length;
+        return true;
+    }
+    return stable_phase ? stable_luby.should_restart(formula) : focused.should_restart(formula);
+}
+
+void AlternatingStrategy::restarted(const Formula &formula) {
+    if (stable_phase) stable_luby.restarted(formula);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "strategies/restart/GlucoseStrategy.h"
+#include "strategies/restart/LubyStrategy.h"
+
+// Alternates between focused phases with glucose restarts and stable phases with rare Luby restarts, each phase
+// lasting longer than the previous one.
+class AlternatingStrategy final : public RestartStrategy {
+public:
+    AlternatingStrategy();
+
+    void initialize(const Formula &formula) override;
+
+    void conflict(const Formula &formula, uint32_t lbd) override;
+
+    bool should_restart(const Formula &formula) override;
+
+    void restarted(const Formula &formula) override;
+
+    bool stable() const override {
+        return stable_phase;
+    }
+
+private:
+    GlucoseStrategy focused;
+    LubyStrategy stable_luby;
+
+    bool stable_phase = false;
+    long phase_length;
+    long phase_end;
+};
@@ -0,0 +1,32 @@
+#include "GlucoseStrategy.h"
+
+#define FAST_ALPHA 0.03
+#define SLOW_ALPHA 1e-5
+#define TRAIL_ALPHA 2e-4
+#define RESTART_MARGIN 1.1
+#define MIN_RESTART_CONFLICTS 2
+#define BLOCKING_MARGIN 1.4
+#define BLOCKING_START 10000
+#define BLOCKING_CONFLICTS 50
+
+void GlucoseStrategy::initialize(const Formula &) {
+    fast_lbd = MovingAverage(FAST_ALPHA);
+    slow_lbd = MovingAverage(SLOW_ALPHA);
+    trail_size = MovingAverage(TRAIL_ALPHA);
+    blocked_until = 0;
+}
+
+void GlucoseStrategy::conflict(const Formula &formula, uint32_t lbd) {
+    auto size = static_cast<double>(formula.trail.size());
+    if (formula.conflicts_count > BLOCKING_START && size > BLOCKING_MARGIN * trail_size.get()) {
+        blocked_until = formula.conflicts_count + BLOCKING_CONFLICTS;
+    }
+    trail_size.update(size);
+    fast_lbd.update(lbd);
+    slow_lbd.update(lbd);
+}
+
+bool GlucoseStrategy::should_restart(const Formula &formula) {
+    return formula.new_conflicts >= MIN_RESTART_CONFLICTS && formula.conflicts_count >= blocked_until &&
+           fast_lbd.get() > RESTART_MARGIN * slow_lbd.get();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "strategies/restart/RestartStrategy.h"
+
+// Exponential moving average, corrected for its bias towards the initial zero during the first updates.
+class MovingAverage {
+public:
+    explicit MovingAverage(double alpha) : alpha(alpha) {}
+
+    void update(double sample) {
+        biased += alpha * (sample - biased);
+        decay *= 1 - alpha;
+        value = biased / (1 - decay);
+    }
+
+    double get() const {
+        return value;
+    }
+
+private:
+    double alpha;
+    double biased = 0;
+    double decay = 1;
+    double value = 0;
+};
+
+// Restarts when the recent learned clauses get worse than usual, i.e. the fast moving average of their LBD exceeds
+// the slow one by a margin. A conflict with a much larger trail than usual suggests the search is getting close to
+// a model, and blocks restarts for a while.
+class GlucoseStrategy final : public RestartStrategy {
+public:
+    void initialize(const Formula &formula) override;
+
+    void conflict(const Formula &formula, uint32_t lbd) override;
+
+    bool should_restart(const Formula &formula) override;
+
+private:
+    MovingAverage fast_lbd{0};
+    MovingAverage slow_lbd{0};
+    MovingAverage trail_size{0};
+
+    long blocked_until = 0;
+};
@@ -0,0 +1,31 @@
+#include "LubyStrategy.h"
+
+void LubyStrategy::initialize(const Formula &) {
+    restarts = 0;
+    limit = unit;
+}
+
+bool LubyStrategy::should_restart(const Formula &formula) {
+    return formula.new_conflicts >= limit;
+}
+
+void LubyStrategy::restarted(const Formula &) {
+    restarts++;
+    limit = unit * luby(restarts);
+}
+
+long LubyStrategy::luby(long index) {
+    // Find the finite subsequence containing the index, then its position in there.
+    long size = 1;
+    long exponent = 0;
+    while (size < index + 1) {
+        exponent++;
+        size = 2 * size + 1;
+    }
+    while (size - 1 != index) {
+        size = (size - 1) >> 1;
+        exponent--;
+        index = index % size;
+    }
+    return 1L << exponent;
+}
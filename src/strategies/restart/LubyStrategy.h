@@ -0,0 +1,22 @@
+#pragma once
+
+#include "strategies/restart/RestartStrategy.h"
+
+// Restarts after unit * luby(i) conflicts, with luby = 1 1 2 1 1 2 4 1 1 2 1 1 2 4 8 ...
+class LubyStrategy final : public RestartStrategy {
+public:
+    explicit LubyStrategy(long unit) : unit(unit) {}
+
+    void initialize(const Formula &formula) override;
+
+    bool should_restart(const Formula &formula) override;
+
+    void restarted(const Formula &formula) override;
+
+    static long luby(long index);
+
+private:
+    long unit;
+    long restarts = 0;
+    long limit;
+};
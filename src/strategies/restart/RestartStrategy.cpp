@@ -0,0 +1,16 @@
+#include "strategies/restart/AlternatingStrategy.h"
+#include "strategies/restart/GlucoseStrategy.h"
+#include "strategies/restart/LubyStrategy.h"
+#include "strategies/restart/RestartStrategy.h"
+
+std::unique_ptr<RestartStrategy> make_restart_strategy(RestartPolicy policy, long luby_unit) {
+    switch (policy) {
+        case RESTART_LUBY:
+            return std::unique_ptr<RestartStrategy>(new LubyStrategy(luby_unit));
+        case RESTART_GLUCOSE:
+            return std::unique_ptr<RestartStrategy>(new GlucoseStrategy());
+        case RESTART_ALTERNATING:
+            return std::unique_ptr<RestartStrategy>(new AlternatingStrategy());
+    }
+    return nullptr;
+}
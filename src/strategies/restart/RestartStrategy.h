@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+
+#include "Formula.h"
+
+// Conflicts per step of the Luby sequence.
+#define LUBY_UNIT 64
+
+enum RestartPolicy {
+    RESTART_LUBY, RESTART_GLUCOSE, RESTART_ALTERNATING
+};
+
+// Decides when the search backtracks towards the top level. How far it goes back is up to the branching strategy,
+// which keeps the decisions it would repeat right away.
+class RestartStrategy {
+public:
+    virtual ~RestartStrategy() = default;
+
+    // Called once before the search starts.
+    virtual void initialize(const Formula &) {}
+
+    // Called for every conflict with the LBD of the learned clause, before backjumping.
+    virtual void conflict(const Formula &, uint32_t) {}
+
+    // Asked before every decision.
+    virtual bool should_restart(const Formula &formula) = 0;
+
+    // Called after every restart.
+    virtual void restarted(const Formula &) {}
+
+    // Whether the search is in a stable phase, with few restarts, rather than a focused one.
+    virtual bool stable() const {
+        return false;
+    }
+};
+
+// Luby restarts are scaled by `luby_unit` conflicts.
+std::unique_ptr<RestartStrategy> make_restart_strategy(RestartPolicy policy, long luby_unit);
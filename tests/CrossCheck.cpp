@@ -0,0 +1,300 @@
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Formulas have at most this many variables, few enough to decide them by trying every assignment.
+#define MAX_VARIABLES 16
+#define DEFAULT_INSTANCES 200
+#define DEFAULT_SEED 1
+// Clauses per variable of the formulas with a hidden model, around the threshold of random 3-SAT.
+#define PLANTED_RATIO 4.2
+
+// Runs the solver on small random formulas and checks its answers against brute force: models against the clauses,
+// and UNSAT results against there being no model at all. Proofs of the UNSAT results are checked by the solver
+// itself when a proof format is given, and must be VERIFIED.
+namespace {
+
+    typedef std::vector<std::vector<int>> Clauses;
+
+    struct Options {
+        std::string solver;
+        std::vector<std::string> solver_arguments;
+        long instances = DEFAULT_INSTANCES;
+        unsigned seed = DEFAULT_SEED;
+        std::string proof_format;
+        // Copies of a random block of clauses over disjoint variables, which have symmetries to break.
+        bool symmetric = false;
+        // Variables of random 3-SAT formulas built around a hidden model, too many to try every assignment but known
+        // to be satisfiable. 0 for the small formulas.
+        int planted = 0;
+        // Only the satisfiable formulas are given to the solver, for modes that can't refute one.
+        bool sat_only = false;
+        // Longest delay in milliseconds after which the solver is interrupted, 0 for none. It may then answer UNKNOWN,
+        // or be killed if it hasn't installed its handler yet, but never give a wrong answer.
+        long interrupt = 0;
+    };
+
+    // Mostly random 3-SAT around the threshold, with some short, tautological and duplicate clauses, and rarely an
+    // empty one.
+    Clauses random_formula(std::mt19937 &random, int &variables) {
+        variables = std::uniform_int_distribution<int>(4, MAX_VARIABLES)(random);
+        std::uniform_int_distribution<int> variable(1, variables);
+        std::uniform_int_distribution<int> percent(0, 99);
+        auto clauses_count = static_cast<size_t>(variables * std::uniform_real_distribution<double>(3.5, 7.0)(random));
+        Clauses clauses;
+        while (clauses.size() < clauses_count) {
+            int roll = percent(random);
+            size_t size = roll < 2 ? 1 : roll < 4 ? 2 : roll < 97 ? 3 : 4;
+            std::vector<int> clause;
+            while (clause.size() < size) {
+                int literal = percent(random) < 50 ? variable(random) : -variable(random);
+                bool repeated = false;
+                for (const int &other: clause) {
+                    repeated = repeated || std::abs(other) == std::abs(literal);
+                }
+                if (!repeated || percent(random) < 5) clause.push_back(literal);
+            }
+            clauses.push_back(clause);
+            if (percent(random) < 3) clauses.push_back(clause);
+        }
+        if (percent(random) < 2) clauses.emplace_back();
+        return clauses;
+    }
+
+    Clauses symmetric_formula(std::mt19937 &random, int &variables) {
+        int block = std::uniform_int_distribution<int>(2, 5)(random);
+        int copies = std::uniform_int_distribution<int>(2, MAX_VARIABLES / block)(random);
+        variables = block * copies;
+        std::uniform_int_distribution<int> variable(1, block);
+        std::uniform_int_distribution<int> percent(0, 99);
+        auto block_clauses = static_cast<size_t>(block * std::uniform_real_distribution<double>(2.0, 5.0)(random));
+        Clauses pattern;
+        for (size_t i = 0; i < block_clauses; i++) {
+            std::vector<int> clause;
+            for (size_t j = 0; j < 3; j++) {
+                clause.push_back(percent(random) < 50 ? variable(random) : -variable(random));
+            }
+            pattern.push_back(clause);
+        }
+        // At most one copy may set the first variable of its block.
+        Clauses clauses;
+        for (int copy = 0; copy < copies; copy++) {
+            for (const std::vector<int> &clause: pattern) {
+                std::vector<int> shifted;
+                for (const int &literal: clause) {
+                    shifted.push_back(literal > 0 ? literal + copy * block : literal - copy * block);
+                }
+                clauses.push_back(shifted);
+            }
+            for (int other = copy + 1; other < copies; other++) {
+                clauses.push_back({-(1 + copy * block), -(1 + other * block)});
+            }
+        }
+        return clauses;
+    }
+
+    // Only keeps the clauses the hidden model satisfies.
+    Clauses planted_formula(std::mt19937 &random, int variables) {
+        std::uniform_int_distribution<int> variable(1, variables);
+        std::uniform_int_distribution<int> percent(0, 99);
+        std::vector<bool> model(static_cast<size_t>(variables) + 1);
+        for (int i = 1; i <= variables; i++) {
+            model[static_cast<size_t>(i)] = percent(random) < 50;
+        }
+        auto clauses_count = static_cast<size_t>(variables * PLANTED_RATIO);
+        Clauses clauses;
+        while (clauses.size() < clauses_count) {
+            std::vector<int> clause;
+            bool satisfied = false;
+            while (clause.size() < 3) {
+                int literal = percent(random) < 50 ? variable(random) : -variable(random);
+                bool repeated = false;
+                for (const int &other: clause) {
+                    repeated = repeated || std::abs(other) == std::abs(literal);
+                }
+                if (repeated) continue;
+                clause.push_back(literal);
+                satisfied = satisfied || model[static_cast<size_t>(std::abs(literal))] == (literal > 0);
+            }
+            if (satisfied) clauses.push_back(clause);
+        }
+        return clauses;
+    }
+
+    bool satisfies(const Clauses &clauses, const std::vector<bool> &values) {
+        for (const std::vector<int> &clause: clauses) {
+            bool satisfied = false;
+            for (const int &literal: clause) {
+                satisfied = satisfied || values[static_cast<size_t>(std::abs(literal))] == (literal > 0);
+            }
+            if (!satisfied) return false;
+        }
+        return true;
+    }
+
+    bool brute_force(const Clauses &clauses, int variables) {
+        std::vector<bool> values(static_cast<size_t>(variables) + 1);
+        for (unsigned long bits = 0; bits < 1ul << variables; bits++) {
+            for (int variable = 1; variable <= variables; variable++) {
+                values[static_cast<size_t>(variable)] = (bits >> (variable - 1)) & 1;
+            }
+            if (satisfies(clauses, values)) return true;
+        }
+        return false;
+    }
+
+    void write_formula(const std::string &path, const Clauses &clauses, int variables) {
+        std::ofstream output(path);
+        output << "p cnf " << variables << " " << clauses.size() << "\n";
+        for (const std::vector<int> &clause: clauses) {
+            for (const int &literal: clause) {
+                output << literal << " ";
+            }
+            output << "0\n";
+        }
+    }
+
+    // Runs the command through the shell and returns its standard output and exit status.
+    int run(const std::string &command, std::string &output) {
+        FILE *pipe = popen(command.c_str(), "r");
+        if (pipe == nullptr) return -1;
+        output.clear();
+        char chunk[1 << 12];
+        size_t count;
+        while ((count = fread(chunk, 1, sizeof(chunk), pipe)) > 0) {
+            output.append(chunk, count);
+        }
+        int status = pclose(pipe);
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+
+    std::string json_string(const std::string &line, const std::string &key) {
+        std::string pattern = "\"" + key + "\": \"";
+        size_t position = line.find(pattern);
+        if (position == std::string::npos) return "";
+        position += pattern.size();
+        return line.substr(position, line.find('"', position) - position);
+    }
+
+    // Reads the "Solution" member, pairs of a variable and its value.
+    std::vector<bool> read_model(const std::string &solution, int variables) {
+        std::vector<bool> values(static_cast<size_t>(variables) + 1);
+        size_t position = 0;
+        while (position < solution.size()) {
+            size_t space = solution.find(' ', position);
+            long variable = std::strtol(solution.c_str() + position, nullptr, 10);
+            size_t end = solution.find(' ', space + 1);
+            std::string value = solution.substr(space + 1, end == std::string::npos ? end : end - space - 1);
+            if (variable >= 1 && variable <= variables) values[static_cast<size_t>(variable)] = value == "true";
+            position = end == std::string::npos ? solution.size() : end + 1;
+        }
+        return values;
+    }
+
+    // Returns an empty string if the solver got it right, else what went wrong.
+    std::string check(const Options &options, std::mt19937 &random, const std::string &path, const Clauses &clauses,
+                      int variables, bool sat) {
+        std::string command;
+        if (options.interrupt > 0) {
+            long delay = std::uniform_int_distribution<long>(0, options.interrupt)(random);
+            command = "timeout --preserve-status -s INT " + std::to_string(delay / 1000.0) + " ";
+        }
+        command += options.solver;
+        for (const std::string &argument: options.solver_arguments) {
+            command += " " + argument;
+        }
+        std::string proof_path = path + ".proof";
+        if (!options.proof_format.empty()) {
+            command += " --proof " + proof_path + " --proof-format " + options.proof_format + " --check";
+        }
+        command += " " + path + " 2>/dev/null";
+
+        std::string output;
+        int status = run(command, output);
+        if (!options.proof_format.empty()) std::remove(proof_path.c_str());
+        // Interrupted before the handler was installed.
+        if (options.interrupt > 0 && status == 128 + SIGINT) return "";
+        if (status != 0) return "the solver failed";
+        std::string result = json_string(output, "Result");
+        if (options.interrupt > 0 && result == "UNKNOWN") return "";
+        if (result != (sat ? "SAT" : "UNSAT")) return "got " + (result.empty() ? "no result" : result);
+        if (sat && !satisfies(clauses, read_model(json_string(output, "Solution"), variables))) {
+            return "the model doesn't satisfy the formula";
+        }
+        std::string proof = json_string(output, "Proof");
+        if (!sat && !options.proof_format.empty() && proof != "VERIFIED") return "the proof is " + proof;
+        return "";
+    }
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    bool usage_error = argc < 2;
+    for (int i = 2; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--instances" && i + 1 < argc) {
+            options.instances = std::strtol(argv[++i], nullptr, 10);
+        } else if (argument == "--seed" && i + 1 < argc) {
+            options.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (argument == "--proof-format" && i + 1 < argc) {
+            options.proof_format = argv[++i];
+        } else if (argument == "--interrupt" && i + 1 < argc) {
+            options.interrupt = std::strtol(argv[++i], nullptr, 10);
+        } else if (argument == "--planted" && i + 1 < argc) {
+            options.planted = static_cast<int>(std::strtol(argv[++i], nullptr, 10));
+        } else if (argument == "--symmetric") {
+            options.symmetric = true;
+        } else if (argument == "--sat-only") {
+            options.sat_only = true;
+        } else if (argument == "--") {
+            // Everything after is passed on to the solver.
+            options.solver_arguments.assign(argv + i + 1, argv + argc);
+            break;
+        } else {
+            usage_error = true;
+        }
+    }
+    if (usage_error) {
+        std::cerr << "Usage: " << argv[0] << " <solver> [--instances N] [--seed S] [--proof-format FORMAT]"
+                  << " [--interrupt MILLISECONDS] [--symmetric] [--planted VARIABLES] [--sat-only]"
+                  << " [-- solver arguments]" << std::endl;
+        return 1;
+    }
+    options.solver = argv[1];
+
+    std::string path = "cross-check-" + std::to_string(getpid()) + ".cnf";
+    std::mt19937 random(options.seed);
+    long failures = 0;
+    long checked = 0;
+    for (long instance = 0; instance < options.instances; instance++) {
+        int variables = options.planted;
+        Clauses clauses;
+        if (options.planted > 0) {
+            clauses = planted_formula(random, variables);
+        } else {
+            clauses = options.symmetric ? symmetric_formula(random, variables) : random_formula(random, variables);
+        }
+        bool sat = options.planted > 0 || brute_force(clauses, variables);
+        if (options.sat_only && !sat) continue;
+        write_formula(path, clauses, variables);
+        checked++;
+        std::string failure = check(options, random, path, clauses, variables, sat);
+        if (failure.empty()) continue;
+        failures++;
+        std::cerr << "instance " << instance << " (" << (sat ? "SAT" : "UNSAT") << "): " << failure << std::endl;
+        // Kept for reproducing the failure.
+        std::string kept = "cross-check-failure-" + std::to_string(instance) + ".cnf";
+        write_formula(kept, clauses, variables);
+    }
+    std::remove(path.c_str());
+    std::cout << checked << " instances checked, " << failures << " failed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
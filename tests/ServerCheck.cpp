@@ -0,0 +1,144 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Pigeons of the job that runs into the conflict limit, one more than there are holes.
+#define PIGEONS 9
+#define CONFLICTS_LIMIT 10
+
+// Sends the solver in server mode a stream of well-formed and broken jobs and checks every answer.
+namespace {
+
+    struct Expectation {
+        std::string name;
+        // Text the answer must contain.
+        std::vector<std::string> contents;
+    };
+
+    std::string pigeonhole() {
+        int holes = PIGEONS - 1;
+        std::vector<std::vector<int>> clauses;
+        for (int pigeon = 0; pigeon < PIGEONS; pigeon++) {
+            std::vector<int> clause;
+            for (int hole = 0; hole < holes; hole++) {
+                clause.push_back(1 + pigeon * holes + hole);
+            }
+            clauses.push_back(clause);
+        }
+        for (int hole = 0; hole < holes; hole++) {
+            for (int pigeon = 0; pigeon < PIGEONS; pigeon++) {
+                for (int other = pigeon + 1; other < PIGEONS; other++) {
+                    clauses.push_back({-(1 + pigeon * holes + hole), -(1 + other * holes + hole)});
+                }
+            }
+        }
+        std::ostringstream text;
+        text << "p cnf " << PIGEONS * holes << " " << clauses.size() << "\n";
+        for (const std::vector<int> &clause: clauses) {
+            for (const int &literal: clause) {
+                text << literal << " ";
+            }
+            text << "0\n";
+        }
+        return text.str();
+    }
+
+    // Runs the command through the shell and returns its standard output, or false if it doesn't exit with 0.
+    bool run(const std::string &command, std::string &output) {
+        FILE *pipe = popen(command.c_str(), "r");
+        if (pipe == nullptr) return false;
+        output.clear();
+        char chunk[1 << 12];
+        size_t count;
+        while ((count = fread(chunk, 1, sizeof(chunk), pipe)) > 0) {
+            output.append(chunk, count);
+        }
+        int status = pclose(pipe);
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    // Returns the answer line of the named job, or an empty string if there is none.
+    std::string answer(const std::vector<std::string> &lines, const std::string &name) {
+        for (const std::string &line: lines) {
+            if (line.find("\"Instance\": \"" + name + "\"") != std::string::npos) return line;
+        }
+        return "";
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <solver>" << std::endl;
+        return 1;
+    }
+
+    std::string path = "server-check-" + std::to_string(getpid()) + ".jobs";
+    {
+        std::ofstream jobs(path);
+        jobs << "job\np cnf 1 1\n1 0\nend\n"
+             << "job sat\nc comment\np cnf 2 2\n1 0\n-1 2 0\nend\n"
+             << "job unsat 30\np cnf 1 2\n1 0\n-1 0\nend\n"
+             << "job malformed\np cnf 1 1\n1 x 0\nend\n"
+             << "job empty\np cnf 0 0\nend\n"
+             << "job huge\np cnf 999999999 4000000000\n1 0\nend\n"
+             << "frobnicate\n"
+             << "job limited\n" << pigeonhole() << "end\n"
+             << "stats\n"
+             << "job cut\np cnf 1 1\n1 0\n";
+    }
+    std::vector<Expectation> expectations = {
+            {"job-1",     {"\"Result\": \"SAT\"", "\"Solution\": \"1 true\""}},
+            {"sat",       {"\"Result\": \"SAT\"", "\"Solution\": \"1 true 2 true\""}},
+            {"unsat",     {"\"Result\": \"UNSAT\""}},
+            {"malformed", {"\"Error\": \"malformed:2: "}},
+            {"empty",     {"\"Result\": \"SAT\"", "\"Solution\": \"\""}},
+            {"huge",      {"\"Result\": \"SAT\"", "\"Solution\": \"1 true\""}},
+            {"limited",   {"\"Result\": \"UNKNOWN\""}},
+    };
+
+    std::string output;
+    bool exited = run(argv[1] + std::string(" --server --threads 2 --no-symmetry --conflicts ") +
+                      std::to_string(CONFLICTS_LIMIT) + " < " + path, output);
+    std::remove(path.c_str());
+    if (!exited) {
+        std::cerr << "the server failed" << std::endl;
+        return 1;
+    }
+    std::vector<std::string> lines;
+    std::istringstream stream(output);
+    std::string line;
+    while (std::getline(stream, line)) {
+        lines.push_back(line);
+    }
+
+    long failures = 0;
+    for (const Expectation &expectation: expectations) {
+        std::string text = answer(lines, expectation.name);
+        for (const std::string &content: expectation.contents) {
+            if (text.find(content) != std::string::npos) continue;
+            failures++;
+            std::cerr << "job " << expectation.name << ": expected " << content << ", got "
+                      << (text.empty() ? "no answer" : text) << std::endl;
+        }
+    }
+    // Besides the jobs, the unknown command and the stats are answered, and the job cut off by the end of the input
+    // is dropped.
+    size_t errors = 0;
+    size_t stats = 0;
+    for (const std::string &other: lines) {
+        errors += other == R"({"Error": "unknown command 'frobnicate'"})";
+        stats += other.compare(0, 11, R"({"Queued": )") == 0;
+    }
+    if (errors != 1 || stats != 1 || !answer(lines, "cut").empty() || lines.size() != expectations.size() + 2) {
+        failures++;
+        std::cerr << "unexpected answers:\n" << output;
+    }
+    std::cout << expectations.size() << " jobs checked, " << failures << " failed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Solver.h"
+
+#define VARIABLES 12
+#define SESSIONS 200
+#define STEPS 12
+#define PIGEONS 7
+
+// Drives the incremental interface through sessions of clauses added between searches under random assumptions,
+// and checks every answer against brute force: models against the clauses and assumptions, and failed searches
+// against the failed assumptions being unsatisfiable together with the clauses.
+namespace {
+
+    typedef std::vector<std::vector<long>> Clauses;
+
+    long failures = 0;
+
+    void fail(long session, const std::string &message) {
+        failures++;
+        std::cerr << "session " << session << ": " << message << std::endl;
+    }
+
+    bool satisfies(const Clauses &clauses, unsigned long bits) {
+        for (const std::vector<long> &clause: clauses) {
+            bool satisfied = false;
+            for (const long &literal: clause) {
+                satisfied = satisfied || ((bits >> (std::labs(literal) - 1)) & 1) == (literal > 0);
+            }
+            if (!satisfied) return false;
+        }
+        return true;
+    }
+
+    // Whether the clauses have a model in which the literals hold.
+    bool brute_force(const Clauses &clauses, const std::vector<long> &literals) {
+        Clauses all = clauses;
+        for (const long &literal: literals) {
+            all.push_back({literal});
+        }
+        for (unsigned long bits = 0; bits < 1ul << VARIABLES; bits++) {
+            if (satisfies(all, bits)) return true;
+        }
+        return false;
+    }
+
+    void check_session(std::mt19937 &random, long session) {
+        std::uniform_int_distribution<long> variable(1, VARIABLES);
+        std::uniform_int_distribution<int> percent(0, 99);
+        auto random_literal = [&]() {
+            return percent(random) < 50 ? variable(random) : -variable(random);
+        };
+
+        Solver solver;
+        Clauses clauses;
+        for (int step = 0; step < STEPS; step++) {
+            int added = std::uniform_int_distribution<int>(2, 8)(random);
+            for (int i = 0; i < added; i++) {
+                std::vector<long> clause;
+                int size = percent(random) < 10 ? 2 : 3;
+                for (int j = 0; j < size; j++) {
+                    clause.push_back(random_literal());
+                }
+                solver.add_clause(clause);
+                clauses.push_back(clause);
+            }
+            std::vector<long> assumptions;
+            int assumed = std::uniform_int_distribution<int>(0, 3)(random);
+            for (int i = 0; i < assumed; i++) {
+                assumptions.push_back(random_literal());
+            }
+
+            bool sat = solver.solve(assumptions);
+            bool expected = brute_force(clauses, assumptions);
+            if (solver.stopped()) {
+                fail(session, "stopped without a limit");
+            } else if (sat != expected) {
+                fail(session, std::string("got ") + (sat ? "SAT" : "UNSAT") + " at step " + std::to_string(step));
+            } else if (sat) {
+                std::vector<long> model = solver.model();
+                unsigned long bits = 0;
+                for (const long &literal: model) {
+                    if (literal > 0 && literal <= VARIABLES) bits |= 1ul << (literal - 1);
+                }
+                bool holds = satisfies(clauses, bits);
+                for (const long &assumption: assumptions) {
+                    holds = holds && solver.value(assumption) == T;
+                }
+                if (!holds) fail(session, "the model doesn't satisfy the clauses and assumptions");
+            } else {
+                std::vector<long> failed = solver.failed_assumptions();
+                for (const long &literal: failed) {
+                    bool assumed_literal = false;
+                    for (const long &assumption: assumptions) {
+                        assumed_literal = assumed_literal || assumption == literal;
+                    }
+                    if (!assumed_literal) fail(session, "failed literal " + std::to_string(literal) + " not assumed");
+                }
+                if (brute_force(clauses, failed)) fail(session, "the failed assumptions are satisfiable");
+            }
+            // Once the clauses are unsatisfiable, they stay so.
+            if (!brute_force(clauses, {})) return;
+        }
+    }
+
+    // A search stopped by its conflict limit gives no answer, and a later one without it still does.
+    void check_limits() {
+        Solver solver;
+        int holes = PIGEONS - 1;
+        for (long pigeon = 0; pigeon < PIGEONS; pigeon++) {
+            std::vector<long> clause;
+            for (long hole = 0; hole < holes; hole++) {
+                clause.push_back(1 + pigeon * holes + hole);
+            }
+            solver.add_clause(clause);
+        }
+        for (long hole = 0; hole < holes; hole++) {
+            for (long pigeon = 0; pigeon < PIGEONS; pigeon++) {
+                for (long other = pigeon + 1; other < PIGEONS; other++) {
+                    solver.add_clause({-(1 + pigeon * holes + hole), -(1 + other * holes + hole)});
+                }
+            }
+        }
+        solver.formula().limits.conflicts = 1;
+        if (solver.solve() || !solver.stopped()) fail(-1, "the conflict limit didn't stop the search");
+        solver.formula().limits.conflicts = LONG_MAX;
+        if (solver.solve() || solver.stopped()) fail(-1, "the pigeonhole formula wasn't refuted");
+        if (!solver.failed_assumptions().empty()) fail(-1, "failed assumptions without assumptions");
+    }
+}
+
+int main() {
+    std::mt19937 random(1);
+    for (long session = 0; session < SESSIONS; session++) {
+        check_session(random, session);
+    }
+    check_limits();
+    std::cout << SESSIONS << " sessions checked, " << failures << " failures" << std::endl;
+    return failures == 0 ? 0 : 1;
+}